@@ -0,0 +1,499 @@
+/// # Allocator benchmarks
+/**
+ * Runs a set of repeatable workloads against each of the memory resources
+ * and prints one JSON object per line for each workload/resource pair:
+ *
+ * ```
+ * felspar-memory-bench [workload [resource]]
+ * ```
+ *
+ * Either argument filters the runs to those whose name matches exactly.
+ * Latencies are measured for every individual allocation and deallocation
+ * so include the cost of reading the clock. The peak resident set size is
+ * the high water mark for the whole process, so to compare resources by
+ * memory use run each one in its own process.
+ */
+
+
+#include <felspar/memory/arena.pmr.hpp>
+#include <felspar/memory/bitmap-pool.pmr.hpp>
+#include <felspar/memory/concurrent-fixed-pool.pmr.hpp>
+#include <felspar/memory/fixed-pool.pmr.hpp>
+#include <felspar/memory/magazine-cache.pmr.hpp>
+#include <felspar/memory/segregated-pool.pmr.hpp>
+#include <felspar/memory/slab.storage.hpp>
+#include <felspar/memory/stack.storage.hpp>
+#include <felspar/memory/storage-resource.pmr.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string_view>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#if __has_include(<sys/resource.h>)
+#include <sys/resource.h>
+#define FELSPAR_MEMORY_BENCH_RUSAGE
+#endif
+
+
+namespace {
+
+
+    using clock_type = std::chrono::steady_clock;
+
+
+    /// ## Repeatable random numbers
+    /**
+     * The standard distributions differ between standard libraries, so a
+     * simple xorshift generator is used to get the same sequence everywhere.
+     */
+    struct random_numbers {
+        std::uint64_t state = 0x9e37'79b9'7f4a'7c15u;
+
+        std::uint64_t operator()() noexcept {
+            state ^= state << 13;
+            state ^= state >> 7;
+            state ^= state << 17;
+            return state;
+        }
+        /// Return a number in the closed range `[low, high]`
+        std::size_t between(std::size_t const low, std::size_t const high) {
+            return low + (*this)() % (high - low + 1u);
+        }
+    };
+
+
+    /// ## Latency samples
+    class latencies {
+        std::vector<std::int64_t> samples;
+
+      public:
+        explicit latencies(std::size_t const expected) {
+            samples.reserve(expected);
+        }
+
+        /// Time a single operation
+        template<typename F>
+        decltype(auto) time(F &&f) {
+            auto const start = clock_type::now();
+            if constexpr (std::is_void_v<decltype(f())>) {
+                f();
+                record(start);
+            } else {
+                auto r = f();
+                record(start);
+                return r;
+            }
+        }
+        void merge(latencies const &l) {
+            samples.insert(samples.end(), l.samples.begin(), l.samples.end());
+        }
+
+        std::size_t size() const noexcept { return samples.size(); }
+        /// Return the latency in nanoseconds at the requested fraction
+        std::int64_t percentile(double const p) {
+            if (samples.empty()) { return {}; }
+            auto const index = static_cast<std::ptrdiff_t>(
+                    p * static_cast<double>(samples.size() - 1u));
+            auto const at = samples.begin() + index;
+            std::nth_element(samples.begin(), at, samples.end());
+            return *at;
+        }
+
+      private:
+        void record(clock_type::time_point const start) {
+            samples.push_back(
+                    std::chrono::duration_cast<std::chrono::nanoseconds>(
+                            clock_type::now() - start)
+                            .count());
+        }
+    };
+
+
+    /// ## The resources under test
+    /**
+     * `malloc` isn't a memory resource so it is wrapped in one, using
+     * `std::aligned_alloc` for over-aligned requests.
+     */
+    class malloc_resource : public felspar::pmr::memory_resource {
+        void *do_allocate(std::size_t bytes, std::size_t alignment) override {
+            void *p = nullptr;
+            if (alignment <= alignof(std::max_align_t)) {
+                p = std::malloc(bytes);
+            } else {
+                p = std::aligned_alloc(
+                        alignment,
+                        felspar::memory::block_size(bytes, alignment));
+            }
+            if (not p) { throw std::bad_alloc{}; }
+            return p;
+        }
+        void do_deallocate(void *p, std::size_t, std::size_t) override {
+            std::free(p);
+        }
+        bool do_is_equal(memory_resource const &other) const noexcept override {
+            return this == &other;
+        }
+    };
+
+
+    /// An instance of a resource ready to run a workload against
+    struct subject {
+        /// Keeps the resource (and anything it depends on) alive
+        std::shared_ptr<void> owner;
+        felspar::pmr::memory_resource *resource;
+        /// Called between rounds of the scratch workloads to release all
+        /// memory, which is needed by the resources that never reuse memory
+        std::function<void()> reset = [] {};
+    };
+    template<typename R, typename... Args>
+    subject make_subject(Args &&...args) {
+        auto r = std::make_shared<R>(std::forward<Args>(args)...);
+        return {r, r.get()};
+    }
+
+    struct candidate {
+        std::string_view name;
+        /// Can be used from more than one thread at a time
+        bool thread_safe;
+        /// Memory that is deallocated can be allocated again without a reset
+        bool reuses_memory;
+        /// Create the resource for allocations of up to the given size
+        std::function<subject(std::size_t)> make;
+    };
+
+    auto *const upstream = felspar::pmr::new_delete_resource();
+    constexpr std::size_t storage_bytes = 4u << 20;
+
+    std::vector<candidate> const candidates = {
+            {"malloc", true, true,
+             [](std::size_t) { return make_subject<malloc_resource>(); }},
+            {"new_delete", true, true,
+             [](std::size_t) {
+                 return subject{nullptr, felspar::pmr::new_delete_resource()};
+             }},
+#ifndef FELSPAR_FORCE_PMR
+            {"std_unsynchronized_pool", false, true,
+             [](std::size_t) {
+                 return make_subject<std::pmr::unsynchronized_pool_resource>(
+                         upstream);
+             }},
+            {"std_synchronized_pool", true, true,
+             [](std::size_t) {
+                 return make_subject<std::pmr::synchronized_pool_resource>(
+                         upstream);
+             }},
+#endif
+            {"fixed_pool", false, true,
+             [](std::size_t const max) {
+                 return make_subject<felspar::memory::fixed_pool>(
+                         max, upstream);
+             }},
+            {"bitmap_pool", false, true,
+             [](std::size_t const max) {
+                 return make_subject<felspar::memory::bitmap_pool>(
+                         max, storage_bytes / max, upstream);
+             }},
+            {"segregated_pool", false, true,
+             [](std::size_t) {
+                 return make_subject<felspar::memory::segregated_pool>(
+                         upstream);
+             }},
+            {"concurrent_fixed_pool", true, true,
+             [](std::size_t const max) {
+                 return make_subject<felspar::memory::concurrent_fixed_pool>(
+                         max, upstream);
+             }},
+            {"magazine_cache", true, true,
+             [](std::size_t const max) {
+                 struct cached {
+                     felspar::memory::concurrent_fixed_pool pool;
+                     felspar::memory::magazine_cache<> cache;
+                     cached(std::size_t const m)
+                     : pool{m, upstream}, cache{m, &pool} {}
+                 };
+                 auto c = std::make_shared<cached>(max);
+                 return subject{c, &c->cache};
+             }},
+            {"stack_storage", false, true,
+             [](std::size_t) {
+                 using resource = felspar::memory::storage_resource<
+                         felspar::memory::stack_storage<storage_bytes, 1024u>>;
+                 return make_subject<resource>(upstream);
+             }},
+            {"slab_storage", false, false,
+             [](std::size_t) {
+                 using resource = felspar::memory::storage_resource<
+                         felspar::memory::slab_storage<storage_bytes>>;
+                 auto r = std::make_shared<resource>(upstream);
+                 return subject{r, r.get(), [r = r.get()]() {
+                                    r->storage().rewind(0u);
+                                }};
+             }},
+            {"arena", false, false,
+             [](std::size_t) {
+                 auto r = std::make_shared<felspar::memory::arena<>>(upstream);
+                 auto const start = r->checkpoint();
+                 return subject{r, r.get(), [r = r.get(), start]() {
+                                    r->rewind(start);
+                                }};
+             }},
+    };
+
+
+    /// ## Workloads
+    struct report {
+        std::size_t operations = {};
+        std::chrono::nanoseconds elapsed = {};
+        latencies timings;
+    };
+
+    constexpr std::size_t churn_rounds = 1000u, churn_batch = 1000u;
+    constexpr std::size_t churn_bytes = 64u;
+
+    /// Allocate a batch of equal sized blocks and then free them all in a
+    /// random order
+    report churn(subject &s) {
+        report r{{}, {}, latencies{2u * churn_rounds * churn_batch}};
+        random_numbers random;
+        std::vector<void *> live(churn_batch);
+        auto const start = clock_type::now();
+        for (std::size_t round{}; round < churn_rounds; ++round) {
+            for (auto &p : live) {
+                p = r.timings.time(
+                        [&]() { return s.resource->allocate(churn_bytes); });
+            }
+            for (std::size_t index{live.size()}; index > 1u; --index) {
+                std::swap(
+                        live[index - 1u], live[random.between(0u, index - 1u)]);
+            }
+            for (auto p : live) {
+                r.timings.time(
+                        [&]() { s.resource->deallocate(p, churn_bytes); });
+            }
+            s.reset();
+        }
+        r.elapsed = clock_type::now() - start;
+        r.operations = r.timings.size();
+        return r;
+    }
+
+
+    constexpr std::size_t fragment_live = 1000u, fragment_operations = 500'000u;
+    constexpr std::size_t fragment_min = 16u, fragment_max = 1024u;
+
+    /// Keep a fixed number of random sized allocations live, repeatedly
+    /// replacing a randomly chosen one with another of a different size
+    report fragmentation(subject &s) {
+        report r{{}, {}, latencies{2u * fragment_operations}};
+        random_numbers random;
+        struct allocation {
+            void *p;
+            std::size_t bytes;
+        };
+        std::vector<allocation> live;
+        auto const start = clock_type::now();
+        for (std::size_t index{}; index < fragment_live; ++index) {
+            auto const bytes = random.between(fragment_min, fragment_max);
+            live.push_back({s.resource->allocate(bytes), bytes});
+        }
+        for (std::size_t op{}; op < fragment_operations; ++op) {
+            auto &a = live[random.between(0u, live.size() - 1u)];
+            r.timings.time([&]() { s.resource->deallocate(a.p, a.bytes); });
+            a.bytes = random.between(fragment_min, fragment_max);
+            a.p = r.timings.time(
+                    [&]() { return s.resource->allocate(a.bytes); });
+        }
+        for (auto const &a : live) { s.resource->deallocate(a.p, a.bytes); }
+        r.elapsed = clock_type::now() - start;
+        r.operations = r.timings.size();
+        return r;
+    }
+
+
+    constexpr std::size_t scratch_rounds = 20'000u, scratch_depth = 64u;
+    constexpr std::size_t scratch_max = 512u;
+
+    /// Build up a stack of random sized scratch allocations and then free
+    /// them in reverse order
+    report lifo_scratch(subject &s) {
+        report r{{}, {}, latencies{2u * scratch_rounds * scratch_depth}};
+        random_numbers random;
+        struct allocation {
+            void *p;
+            std::size_t bytes;
+        };
+        std::vector<allocation> live;
+        live.reserve(scratch_depth);
+        auto const start = clock_type::now();
+        for (std::size_t round{}; round < scratch_rounds; ++round) {
+            auto const depth = random.between(1u, scratch_depth);
+            for (std::size_t index{}; index < depth; ++index) {
+                auto const bytes = random.between(fragment_min, scratch_max);
+                live.push_back(
+                        {r.timings.time([&]() {
+                             return s.resource->allocate(bytes);
+                         }),
+                         bytes});
+            }
+            while (not live.empty()) {
+                auto const a = live.back();
+                live.pop_back();
+                r.timings.time(
+                        [&]() { s.resource->deallocate(a.p, a.bytes); });
+            }
+            s.reset();
+        }
+        r.elapsed = clock_type::now() - start;
+        r.operations = r.timings.size();
+        return r;
+    }
+
+
+    constexpr std::size_t handoff_blocks = 1'000'000u, handoff_batch = 64u;
+
+    /// One thread allocates blocks and passes them in batches to another
+    /// thread which frees them
+    report producer_consumer(subject &s) {
+        report r{{}, {}, latencies{handoff_blocks}};
+        latencies consumed{handoff_blocks};
+        std::mutex mutex;
+        std::condition_variable signal;
+        std::deque<std::vector<void *>> queue;
+        bool finished = false;
+
+        auto const start = clock_type::now();
+        std::thread consumer{[&]() {
+            while (true) {
+                std::vector<void *> batch;
+                {
+                    std::unique_lock lock{mutex};
+                    signal.wait(lock, [&]() {
+                        return finished or not queue.empty();
+                    });
+                    if (queue.empty()) { return; }
+                    batch = std::move(queue.front());
+                    queue.pop_front();
+                }
+                for (auto p : batch) {
+                    consumed.time([&]() {
+                        s.resource->deallocate(p, churn_bytes);
+                    });
+                }
+            }
+        }};
+        std::vector<void *> batch;
+        for (std::size_t index{}; index < handoff_blocks; ++index) {
+            batch.push_back(r.timings.time(
+                    [&]() { return s.resource->allocate(churn_bytes); }));
+            if (batch.size() == handoff_batch) {
+                std::scoped_lock _{mutex};
+                queue.push_back(std::exchange(batch, {}));
+                signal.notify_one();
+            }
+        }
+        {
+            std::scoped_lock _{mutex};
+            if (not batch.empty()) { queue.push_back(std::move(batch)); }
+            finished = true;
+            signal.notify_one();
+        }
+        consumer.join();
+        r.elapsed = clock_type::now() - start;
+        r.timings.merge(consumed);
+        r.operations = r.timings.size();
+        return r;
+    }
+
+
+    struct workload {
+        std::string_view name;
+        std::size_t max_bytes;
+        bool needs_thread_safety, needs_reuse;
+        report (*run)(subject &);
+    };
+    workload const workloads[] = {
+            {"churn", churn_bytes, false, false, churn},
+            {"fragmentation", fragment_max, false, true, fragmentation},
+            {"lifo_scratch", scratch_max, false, false, lifo_scratch},
+            {"producer_consumer", churn_bytes, true, true, producer_consumer},
+    };
+
+
+    /// Return the process' peak resident set size in kilobytes
+    long peak_rss_kb() {
+#ifdef FELSPAR_MEMORY_BENCH_RUSAGE
+        rusage usage{};
+        getrusage(RUSAGE_SELF, &usage);
+#ifdef __APPLE__
+        return usage.ru_maxrss / 1024;
+#else
+        return usage.ru_maxrss;
+#endif
+#else
+        return {};
+#endif
+    }
+
+
+}
+
+
+int main(int const argc, char const *const argv[]) {
+    std::string_view const only_workload = argc > 1 ? argv[1] : "";
+    std::string_view const only_resource = argc > 2 ? argv[2] : "";
+
+    for (auto const &w : workloads) {
+        if (not only_workload.empty() and w.name != only_workload) {
+            continue;
+        }
+        for (auto const &c : candidates) {
+            if ((not only_resource.empty() and c.name != only_resource)
+                or (w.needs_thread_safety and not c.thread_safe)
+                or (w.needs_reuse and not c.reuses_memory)) {
+                continue;
+            }
+            try {
+                auto s = c.make(w.max_bytes);
+                auto r = w.run(s);
+                auto const seconds =
+                        std::chrono::duration<double>(r.elapsed).count();
+                std::printf(
+                        "{\"workload\": \"%.*s\", \"resource\": \"%.*s\", "
+                        "\"operations\": %zu, \"seconds\": %.6f, "
+                        "\"ops_per_second\": %.0f, \"p50_ns\": %lld, "
+                        "\"p99_ns\": %lld, \"p999_ns\": %lld, "
+                        "\"peak_rss_kb\": %ld}\n",
+                        static_cast<int>(w.name.size()), w.name.data(),
+                        static_cast<int>(c.name.size()), c.name.data(),
+                        r.operations, seconds,
+                        static_cast<double>(r.operations) / seconds,
+                        static_cast<long long>(r.timings.percentile(0.5)),
+                        static_cast<long long>(r.timings.percentile(0.99)),
+                        static_cast<long long>(r.timings.percentile(0.999)),
+                        peak_rss_kb());
+            } catch (std::exception const &e) {
+                std::printf(
+                        "{\"workload\": \"%.*s\", \"resource\": \"%.*s\", "
+                        "\"error\": \"%s\"}\n",
+                        static_cast<int>(w.name.size()), w.name.data(),
+                        static_cast<int>(c.name.size()), c.name.data(),
+                        e.what());
+            }
+            std::fflush(stdout);
+        }
+    }
+    return 0;
+}
@@ -3,6 +3,15 @@
 
 #include <felspar/memory/shared_buffer.hpp>
 
+#include <array>
+#include <cstring>
+#include <type_traits>
+
+#if __has_include(<sys/uio.h>) and __has_include(<unistd.h>)
+#include <sys/uio.h>
+#include <unistd.h>
+#endif
+
 
 namespace felspar::memory {
 
@@ -11,24 +20,43 @@ namespace felspar::memory {
     /**
      * A buffer into which data can be accumulated at the end, and consumed from
      * the front.
+     *
+     * Items are held in a single block of memory together with its control
+     * block. When there isn't room in the block for more items, and none of
+     * the consumed items are still in use, the unconsumed items are moved to
+     * the front of the block. Otherwise a new block is allocated and the
+     * unconsumed items are copied into it. The blocks can be allocated from a
+     * memory resource.
+     *
+     * The most items the buffer has needed to hold since the block was last
+     * compacted or replaced is tracked, and if the block has become more than
+     * `shrink_ratio` times larger than this then it is replaced by a smaller
+     * one rather than compacted.
      */
     template<typename T>
     class accumulation_buffer final {
-        using vector_type = typename shared_buffer<T>::vector_type;
+        using block_type = array_control<T>;
+        static constexpr bool uninitialised_ok =
+                std::is_trivially_default_constructible_v<T>
+                and std::is_trivially_destructible_v<T>;
 
         shared_buffer<T> buffer = {};
         std::span<T> occupied = {};
-        vector_type *pvector = {};
-        std::size_t min_buffer = 128;
+        block_type *block = {};
+        std::size_t min_buffer = 128, high_water = {};
+        pmr::memory_resource *resource = pmr::new_delete_resource();
 
       public:
         using buffer_type = shared_buffer<T>;
         using value_type = T;
+        static constexpr std::size_t shrink_ratio = 4u;
 
 
         /// ### Constructors
         accumulation_buffer() {}
         explicit accumulation_buffer(std::size_t mb) : min_buffer{mb} {}
+        accumulation_buffer(std::size_t mb, pmr::memory_resource *const r)
+        : min_buffer{mb}, resource{r} {}
         accumulation_buffer(accumulation_buffer const &) = default;
         accumulation_buffer(accumulation_buffer &&) = default;
 
@@ -41,6 +69,10 @@ namespace felspar::memory {
         /// ### Information about the current state of the buffer
         bool empty() const noexcept { return occupied.empty(); }
         auto size() const noexcept { return occupied.size(); }
+        /// The number of items the current block can hold
+        std::size_t capacity() const noexcept {
+            return block ? block->capacity() : 0u;
+        }
 
 
         /// ### Grow the buffer
@@ -48,24 +80,87 @@ namespace felspar::memory {
         void ensure_length(std::size_t const count, V &&t = {}) {
             if (occupied.size() < count) {
                 auto const needed = count - occupied.size();
-                if (not pvector
-                    or pvector->size() + needed > pvector->capacity()) {
-                    vector_type v;
-                    v.reserve(std::max(count, min_buffer) + occupied.size());
-                    v.insert(v.begin(), occupied.begin(), occupied.end());
-                    v.insert(v.begin() + v.size(), count - v.size(), t);
-                    auto alloc = buffer_type::control_type::wrap_existing(
-                            std::move(v));
-                    pvector = alloc.second;
-                    buffer = buffer_type{std::move(alloc)};
-                    occupied = buffer;
-                } else {
-                    pvector->insert(
-                            pvector->begin() + pvector->size(), needed, t);
-                    occupied = {occupied.data(), count};
+                reserve(needed);
+                block->append(needed, t);
+                occupied = {occupied.data(), count};
+            }
+        }
+
+        /// #### Write into uninitialised memory
+        /**
+         * For types that don't need constructing, `prepare` returns memory
+         * for `count` more items at the end of the buffer without
+         * initialising it. After writing to some or all of it, `commit` adds
+         * the number of items written to the buffer. Any other change to the
+         * buffer in between means the memory has to be prepared again.
+         */
+        std::span<value_type> prepare(std::size_t const count)
+            requires uninitialised_ok
+        {
+            reserve(count);
+            return block->spare().first(count);
+        }
+        void commit(
+                std::size_t const count,
+                std::source_location const &loc =
+                        std::source_location::current())
+            requires uninitialised_ok
+        {
+            if (count > (block and owns_tail() ? block->spare().size() : 0u)) {
+                detail::throw_logic_error(
+                        "Committing more memory than was prepared", loc);
+            }
+            if (count) {
+                block->commit(count);
+                occupied = {occupied.data(), occupied.size() + count};
+            }
+        }
+
+#if __has_include(<sys/uio.h>) and __has_include(<unistd.h>)
+        /// #### Read from a file descriptor
+        /**
+         * Reads up to `count` bytes straight into the end of the buffer. The
+         * return value is that of `read`, so is negative, with `errno` set, on
+         * error and zero at end of file.
+         */
+        ::ssize_t read_from(int const fd, std::size_t const count)
+            requires(uninitialised_ok and sizeof(value_type) == 1)
+        {
+            auto const tail = prepare(count);
+            auto const got = ::read(fd, tail.data(), tail.size());
+            if (got > 0) { commit(static_cast<std::size_t>(got)); }
+            return got;
+        }
+        /**
+         * Uses `readv` to read into whatever spare capacity the buffer
+         * already has, with anything more going into `overflow` and then
+         * being copied onto the end of the buffer. Small reads don't need the
+         * buffer to reserve memory up front, and large ones still need only a
+         * single system call.
+         */
+        ::ssize_t
+                read_from(int const fd, std::span<std::byte> const overflow)
+            requires(uninitialised_ok and sizeof(value_type) == 1)
+        {
+            reserve(0u);
+            auto const tail = block->spare();
+            std::array<::iovec, 2> iov{
+                    ::iovec{tail.data(), tail.size()},
+                    ::iovec{overflow.data(), overflow.size()}};
+            auto const got = ::readv(fd, iov.data(), iov.size());
+            if (got > 0) {
+                auto const read = static_cast<std::size_t>(got);
+                auto const direct = std::min(read, tail.size());
+                commit(direct);
+                if (read > direct) {
+                    auto const more = prepare(read - direct);
+                    std::memcpy(more.data(), overflow.data(), more.size());
+                    commit(more.size());
                 }
             }
+            return got;
         }
+#endif
 
         /// ### Access to the buffer
         std::span<value_type> memory() noexcept { return occupied; }
@@ -106,6 +201,67 @@ namespace felspar::memory {
             occupied = occupied.subspan(count);
             return buffer_type{buffer.owner, part};
         }
+        /**
+         * Consume consecutive slices from the front of the buffer with the
+         * requested sizes. The references for all of the slices are taken
+         * together.
+         */
+        std::vector<buffer_type>
+                split(std::span<std::size_t const> const sizes,
+                      std::source_location const &loc =
+                              std::source_location::current()) {
+            auto slices =
+                    buffer_type::slice(buffer.owner, occupied, sizes, loc);
+            for (auto const &s : slices) {
+                occupied = occupied.subspan(s.size());
+            }
+            return slices;
+        }
+
+
+      private:
+        /// True if the block's items end where the buffer's items end
+        bool owns_tail() const noexcept {
+            return occupied.data() + occupied.size()
+                    == block->data() + block->size();
+        }
+        /**
+         * Make room for `extra` more items directly after the items in the
+         * buffer. If the block is full then the items are moved to the front
+         * of it, if that can be done without disturbing anything else using
+         * it, and otherwise they are copied into a new block. A copy of the
+         * buffer may have appended items after ours, in which case the block
+         * isn't ours to compact even once it is unique again.
+         */
+        void reserve(std::size_t const extra) {
+            auto const wanted = occupied.size() + extra;
+            high_water = std::max(high_water, wanted);
+            if (block and owns_tail()
+                and block->size() + extra <= block->capacity()) {
+                return;
+            }
+            if constexpr (std::is_nothrow_move_assignable_v<T>) {
+                if (block and owns_tail() and wanted <= block->capacity()
+                    and block->capacity()
+                            <= shrink_ratio * std::max(high_water, min_buffer)
+                    and buffer.owner->is_unique()) {
+                    block->erase_front(block->size() - occupied.size());
+                    occupied = {block->data(), occupied.size()};
+                    high_water = wanted;
+                    return;
+                }
+            }
+            auto *const b = block_type::create(
+                    std::max(wanted, min_buffer) + occupied.size(), resource);
+            buffer_type grown{
+                    std::pair{std::unique_ptr<control>{b}, std::span<T>{}}};
+            b->append(occupied.begin(), occupied.end());
+            grown.buffer = b->items();
+            block = b;
+            buffer = std::move(grown);
+            occupied = buffer.buffer;
+            high_water = wanted;
+        }
     };
 
 
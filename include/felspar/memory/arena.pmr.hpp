@@ -0,0 +1,148 @@
+#pragma once
+
+
+#include <felspar/memory/pmr.hpp>
+#include <felspar/memory/slab.storage.hpp>
+
+#include <cstdint>
+#include <new>
+#include <utility>
+
+
+namespace felspar::memory {
+
+
+    /// ## Arena
+    /**
+     * A monotonic memory resource that allocates from an embedded
+     * `slab_storage` first, and when that is full, from a chain of
+     * progressively larger blocks taken from the upstream allocator.
+     * Deallocation does nothing, instead `checkpoint` returns a marker and
+     * `rewind` frees everything allocated after that marker was taken. Blocks
+     * are kept after a rewind and re-used, so an arena that is repeatedly
+     * rewound soon stops needing any upstream allocations at all.
+     *
+     * This allocator is not thread safe.
+     */
+    template<std::size_t S = 16u << 10>
+    class arena : public pmr::memory_resource {
+        struct chunk {
+            chunk *next;
+            std::size_t bytes, used;
+        };
+        static constexpr std::size_t chunk_alignment =
+                alignof(std::max_align_t);
+        static constexpr std::size_t chunk_header =
+                block_size(sizeof(chunk), chunk_alignment);
+
+        void *do_allocate(std::size_t bytes, std::size_t alignment) override {
+            if (not current) {
+                if (auto *const p = slab.try_allocate(bytes, alignment)) {
+                    return p;
+                }
+            } else if (auto *const p = bump(current, bytes, alignment)) {
+                return p;
+            }
+            return grow(bytes, alignment);
+        }
+        void do_deallocate(void *, std::size_t, std::size_t) override {}
+        bool do_is_equal(memory_resource const &other) const noexcept override {
+            return this == &other;
+        }
+
+        slab_storage<S> slab;
+        pmr::memory_resource *upstream;
+        /// When `current` is `nullptr` allocations come from the slab
+        chunk *chunks = nullptr, *current = nullptr;
+        std::size_t next_chunk_bytes = S;
+
+
+      public:
+        /// ### Construction
+        explicit arena(
+                pmr::memory_resource *const upstream =
+                        pmr::new_delete_resource())
+        : upstream{upstream} {}
+        ~arena() { release(); }
+
+        arena(arena const &) = delete;
+        arena &operator=(arena const &) = delete;
+
+
+        /// ### Checkpoints
+        struct marker {
+            chunk *block;
+            std::size_t used;
+        };
+        /// Return a marker for the current allocation position
+        [[nodiscard]] marker checkpoint() const noexcept {
+            if (current) {
+                return {current, current->used};
+            } else {
+                return {nullptr, slab.checkpoint()};
+            }
+        }
+        /// Free everything allocated since the marker was taken
+        void rewind(marker const m) noexcept {
+            current = m.block;
+            if (current) {
+                current->used = m.used;
+            } else {
+                slab.rewind(m.used);
+            }
+        }
+
+
+        /// ### Return all upstream memory
+        void release() noexcept {
+            while (chunks) {
+                auto const bytes = chunk_header + chunks->bytes;
+                upstream->deallocate(
+                        std::exchange(chunks, chunks->next), bytes,
+                        chunk_alignment);
+            }
+            current = nullptr;
+            next_chunk_bytes = S;
+            slab.rewind({});
+        }
+
+
+      private:
+        static std::byte *
+                bump(chunk *const c,
+                     std::size_t const bytes,
+                     std::size_t const alignment) noexcept {
+            auto *const data = reinterpret_cast<std::byte *>(c) + chunk_header;
+            auto const base = reinterpret_cast<std::uintptr_t>(data);
+            std::size_t const start =
+                    aligned_offset(base + c->used, alignment) - base;
+            if (start > c->bytes or bytes > c->bytes - start) {
+                return nullptr;
+            } else {
+                c->used = start + bytes;
+                return data + start;
+            }
+        }
+        void *grow(std::size_t const bytes, std::size_t const alignment) {
+            /// Re-use any blocks left over from before a rewind
+            for (chunk *c = current ? current->next : chunks; c; c = c->next) {
+                current = c;
+                c->used = {};
+                if (auto *const p = bump(c, bytes, alignment)) { return p; }
+            }
+            std::size_t const size = std::max(next_chunk_bytes, bytes + alignment);
+            next_chunk_bytes = std::max(next_chunk_bytes, size) * 2u;
+            auto *const c = new (upstream->allocate(
+                    chunk_header + size, chunk_alignment)) chunk{nullptr, size, {}};
+            if (current) {
+                current->next = c;
+            } else {
+                chunks = c;
+            }
+            current = c;
+            return bump(c, bytes, alignment);
+        }
+    };
+
+
+}
@@ -0,0 +1,154 @@
+#pragma once
+
+
+#include <felspar/memory/bitmap.strategy.hpp>
+#include <felspar/memory/pmr.hpp>
+#include <felspar/memory/sizes.hpp>
+
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+
+namespace felspar::memory {
+
+
+    /// ## Bitmap pool
+    /**
+     * A pool of a fixed number of equal sized blocks that are all carved out of
+     * a single upstream allocation. Block usage is tracked using one bit per
+     * block, and a summary bitmap holds one bit for each word of the block
+     * bitmap which is set when that word is full. Finding a free block is
+     * therefore a trailing ones count on a summary word followed by another on
+     * the block word it points to.
+     *
+     * Allocations that are too large or too aligned for the blocks, or that
+     * arrive when every block is in use, are passed on to the upstream
+     * allocator.
+     *
+     * This pool is not thread safe.
+     */
+    class bitmap_pool : public pmr::memory_resource {
+        using word_type = std::uint64_t;
+        static constexpr std::size_t word_bits = bitmap::bitcount<word_type>;
+        static constexpr std::size_t block_alignment = alignof(std::max_align_t);
+
+        void *do_allocate(std::size_t bytes, std::size_t alignment) override {
+            if (bytes <= block_bytes and alignment <= block_alignment) {
+                if (auto *const b = allocate_block()) { return b; }
+            }
+            return allocator->allocate(bytes, alignment);
+        }
+        void do_deallocate(
+                void *p, std::size_t bytes, std::size_t alignment) override {
+            auto *const b = reinterpret_cast<std::byte *>(p);
+            if (owns(b)) {
+                deallocate_block(b);
+            } else {
+                allocator->deallocate(p, bytes, alignment);
+            }
+        }
+        bool do_is_equal(memory_resource const &other) const noexcept override {
+            return this == &other;
+        }
+
+        std::size_t block_bytes, block_count;
+        pmr::memory_resource *allocator;
+        std::vector<word_type> blocks, summary;
+        /// Lowest summary word that may still have a free block
+        std::size_t hint = {};
+        std::size_t in_use = {};
+        std::byte *base = nullptr;
+
+
+      public:
+        /// ### Construction
+        /**
+         * All of the blocks are allocated from the upstream allocator when the
+         * pool is constructed. The block size is rounded up so that every block
+         * is suitably aligned for any type.
+         */
+        bitmap_pool(
+                std::size_t const block_size,
+                std::size_t const block_count,
+                pmr::memory_resource *const allocator)
+        : block_bytes{memory::block_size(block_size, block_alignment)},
+          block_count{block_count},
+          allocator{allocator},
+          blocks((block_count + word_bits - 1) / word_bits),
+          summary((blocks.size() + word_bits - 1) / word_bits) {
+            /// Mark the bits past the end of the pool as being in use so they
+            /// can never be handed out
+            if (auto const tail = block_count % word_bits) {
+                blocks.back() = ~word_type{} << tail;
+            }
+            if (auto const tail = blocks.size() % word_bits) {
+                summary.back() = ~word_type{} << tail;
+            }
+            if (block_count) {
+                base = reinterpret_cast<std::byte *>(allocator->allocate(
+                        block_bytes * block_count, block_alignment));
+            }
+        }
+        ~bitmap_pool() {
+            if (base) {
+                allocator->deallocate(
+                        base, block_bytes * block_count, block_alignment);
+            }
+        }
+
+        bitmap_pool(bitmap_pool const &) = delete;
+        bitmap_pool &operator=(bitmap_pool const &) = delete;
+
+
+        /// ### Queries
+        [[nodiscard]] std::size_t block_size() const noexcept {
+            return block_bytes;
+        }
+        [[nodiscard]] std::size_t capacity() const noexcept {
+            return block_count;
+        }
+        /// Return the number of blocks that are not in use
+        [[nodiscard]] std::size_t free() const noexcept {
+            return block_count - in_use;
+        }
+        /// Return true if the memory is one of the pool's blocks
+        [[nodiscard]] bool owns(void const *p) const noexcept {
+            auto const *const b = reinterpret_cast<std::byte const *>(p);
+            return base and b >= base and b < base + block_bytes * block_count;
+        }
+
+
+      private:
+        std::byte *word_base(std::size_t const word) const noexcept {
+            return base + word * word_bits * block_bytes;
+        }
+        std::byte *allocate_block() noexcept {
+            for (; hint < summary.size(); ++hint) {
+                if (auto const s = bitmap::nextbit(summary[hint]);
+                    s < word_bits) {
+                    std::size_t const word = hint * word_bits + s;
+                    std::byte *const b = bitmap::allocate(
+                            blocks[word], word_base(word), block_bytes);
+                    if (blocks[word] == ~word_type{}) {
+                        summary[hint] |= word_type{1} << s;
+                    }
+                    ++in_use;
+                    return b;
+                }
+            }
+            return nullptr;
+        }
+        void deallocate_block(std::byte *const b) noexcept {
+            std::size_t const word =
+                    static_cast<std::size_t>(b - base) / block_bytes / word_bits;
+            bitmap::deallocate(b, blocks[word], word_base(word), block_bytes);
+            summary[word / word_bits] &=
+                    ~(word_type{1} << (word % word_bits));
+            hint = std::min(hint, word / word_bits);
+            --in_use;
+        }
+    };
+
+
+}
@@ -1,6 +1,8 @@
 #pragma once
 
 
+#include <bit>
+#include <concepts>
 #include <cstddef>
 
 
@@ -21,19 +23,20 @@ namespace felspar::memory::bitmap {
 
 
     /// Return the memory location that is allocated
-    template<typename BM>
+    /**
+     * The first free location is the number of trailing one bits, which the
+     * compiler turns into a single `tzcnt` (or equivalent) instruction.
+     */
+    template<std::unsigned_integral BM>
     constexpr inline std::size_t nextbit(BM allocations) {
-        std::size_t bit{};
-        for (BM mask{1}; bit < bitcount<BM> and allocations & mask;
-             ++bit, mask = (mask << 1u)) {}
-        return bit;
+        return static_cast<std::size_t>(std::countr_one(allocations));
     }
 
 
-    template<typename BM>
+    template<std::unsigned_integral BM>
     std::byte *allocate(BM &bm, std::byte *base, std::size_t blocksize) {
         if (auto bit = nextbit(bm); bit < bitcount<BM>) {
-            bm |= 1 << bit;
+            bm |= BM{1} << bit;
             return base + blocksize * bit;
         } else {
             return nullptr;
@@ -41,11 +44,11 @@ namespace felspar::memory::bitmap {
     }
 
 
-    template<typename BM>
+    template<std::unsigned_integral BM>
     inline void deallocate(
             std::byte *ptr, BM &bm, std::byte *base, std::size_t blocksize) {
         std::size_t const bit = (ptr - base) / blocksize;
-        bm &= ~(1 << bit);
+        bm &= static_cast<BM>(~(BM{1} << bit));
     }
 
 
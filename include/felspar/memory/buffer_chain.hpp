@@ -0,0 +1,247 @@
+#pragma once
+
+
+#include <felspar/memory/shared_buffer.hpp>
+#include <felspar/memory/shared_vector.hpp>
+
+#include <algorithm>
+#include <vector>
+
+#if __has_include(<sys/uio.h>)
+#include <sys/uio.h>
+#endif
+
+
+namespace felspar::memory {
+
+
+#if __has_include(<sys/uio.h>)
+    using iovec = ::iovec;
+#else
+    /// Matches the layout of the POSIX `iovec`
+    struct iovec {
+        void *iov_base;
+        std::size_t iov_len;
+    };
+#endif
+
+
+    /// ## Chain of shared byte buffers
+    /**
+     * A sequence of `shared_buffer<std::byte>` and `shared_bytes` segments
+     * that together make up a single message, without copying them into one
+     * buffer. Segments can be added at either end in constant (amortised)
+     * time, and bytes can be consumed from the front across segment
+     * boundaries.
+     *
+     * The segments are kept as a contiguous array of `iovec`s so that they
+     * can be passed straight to `writev` or `sendmsg`. Each segment holds a
+     * reference to its memory until it is consumed or the chain is destroyed.
+     */
+    class buffer_chain final {
+        std::vector<iovec> segments;
+        std::vector<control *> owners;
+        /// Index of the first segment, the space before it is for prepending
+        std::size_t first = {};
+        std::size_t bytes = {};
+
+
+      public:
+        /// ### Construction, destruction and assignment
+        buffer_chain() {}
+        buffer_chain(buffer_chain const &bc)
+        : segments{bc.segments.begin() + bc.first, bc.segments.end()},
+          owners{bc.owners.begin() + bc.first, bc.owners.end()},
+          bytes{bc.bytes} {
+            for (auto *o : owners) { control::increment(o); }
+        }
+        buffer_chain(buffer_chain &&bc) noexcept
+        : segments{std::move(bc.segments)},
+          owners{std::move(bc.owners)},
+          first{std::exchange(bc.first, 0u)},
+          bytes{std::exchange(bc.bytes, 0u)} {
+            bc.segments.clear();
+            bc.owners.clear();
+        }
+        buffer_chain &operator=(buffer_chain const &bc) {
+            buffer_chain copy{bc};
+            return *this = std::move(copy);
+        }
+        buffer_chain &operator=(buffer_chain &&bc) noexcept {
+            clear();
+            std::swap(segments, bc.segments);
+            std::swap(owners, bc.owners);
+            std::swap(first, bc.first);
+            std::swap(bytes, bc.bytes);
+            return *this;
+        }
+        ~buffer_chain() { clear(); }
+
+
+        /// ### Adding segments
+        /**
+         * A copy takes a new reference to the memory, whereas a buffer that
+         * is moved in hands its reference over to the chain. Empty buffers
+         * are ignored.
+         *
+         * The chain's references are thread safe, so that the chain can be
+         * handed to another thread. Buffers using `local_counting` are
+         * rejected, and need converting to `atomic_counting` handles first.
+         */
+        template<typename T, typename C>
+            requires std::same_as<std::remove_const_t<T>, std::byte>
+                and (not std::same_as<C, local_counting>)
+        void append(shared_buffer<T, C> const &b) {
+            push_back(b.owner, b.buffer, true);
+        }
+        template<typename T, typename C>
+            requires std::same_as<std::remove_const_t<T>, std::byte>
+                and (not std::same_as<C, local_counting>)
+        void append(shared_buffer<T, C> &&b) {
+            if (push_back(b.owner, b.buffer, false)) {
+                b.owner = nullptr;
+                b.buffer = {};
+            }
+        }
+        template<typename C>
+            requires(not std::same_as<C, local_counting>)
+        void append(shared_vector<std::byte, C> const &v) {
+            push_back(v.owner, v.buffer, true);
+        }
+        template<typename T, typename C>
+            requires std::same_as<std::remove_const_t<T>, std::byte>
+                and (not std::same_as<C, local_counting>)
+        void prepend(shared_buffer<T, C> const &b) {
+            push_front(b.owner, b.buffer, true);
+        }
+        template<typename T, typename C>
+            requires std::same_as<std::remove_const_t<T>, std::byte>
+                and (not std::same_as<C, local_counting>)
+        void prepend(shared_buffer<T, C> &&b) {
+            if (push_front(b.owner, b.buffer, false)) {
+                b.owner = nullptr;
+                b.buffer = {};
+            }
+        }
+        template<typename C>
+            requires(not std::same_as<C, local_counting>)
+        void prepend(shared_vector<std::byte, C> const &v) {
+            push_front(v.owner, v.buffer, true);
+        }
+
+
+        /// ### Information about the chain
+        bool empty() const noexcept { return bytes == 0u; }
+        /// The total number of bytes across all of the segments
+        std::size_t size() const noexcept { return bytes; }
+        std::size_t segment_count() const noexcept {
+            return segments.size() - first;
+        }
+
+
+        /// ### Gathered I/O
+        /**
+         * The segments as an array suitable for `writev` and `sendmsg`. The
+         * span is invalidated by any change to the chain.
+         */
+        std::span<iovec> iovecs() noexcept {
+            return std::span{segments}.subspan(first);
+        }
+
+
+        /// ### Consuming from the front
+        /**
+         * Remove `count` bytes from the front of the chain, for example after
+         * a partial write. Segments that are used up release their memory.
+         */
+        void consume(
+                std::size_t count,
+                std::source_location const &loc =
+                        std::source_location::current()) {
+            if (count > bytes) {
+                detail::throw_logic_error("Buffer overrun", loc);
+            }
+            bytes -= count;
+            while (count) {
+                auto &s = segments[first];
+                if (count < s.iov_len) {
+                    s.iov_base = static_cast<std::byte *>(s.iov_base) + count;
+                    s.iov_len -= count;
+                    return;
+                }
+                count -= s.iov_len;
+                control::decrement(owners[first]);
+                ++first;
+            }
+            if (first == segments.size()) {
+                segments.clear();
+                owners.clear();
+                first = 0u;
+            }
+        }
+        /// Remove all of the segments
+        void clear() noexcept {
+            for (std::size_t index = first; index < owners.size(); ++index) {
+                control::decrement(owners[index]);
+            }
+            segments.clear();
+            owners.clear();
+            first = 0u;
+            bytes = 0u;
+        }
+
+
+      private:
+        template<typename T>
+        bool push_back(
+                control *const o,
+                std::span<T> const memory,
+                bool const take_reference) {
+            if (memory.empty()) { return false; }
+            segments.push_back(to_iovec(memory));
+            try {
+                owners.push_back(o);
+            } catch (...) {
+                segments.pop_back();
+                throw;
+            }
+            if (take_reference) { control::increment(o); }
+            bytes += memory.size();
+            return true;
+        }
+        template<typename T>
+        bool push_front(
+                control *const o,
+                std::span<T> const memory,
+                bool const take_reference) {
+            if (memory.empty()) { return false; }
+            if (first == 0u) {
+                /// Make room in front of the segments for at least as many
+                /// again, so prepending stays constant time amortised
+                auto const room = std::max(segment_count(), std::size_t{4});
+                segments.insert(segments.begin(), room, iovec{});
+                try {
+                    owners.insert(owners.begin(), room, nullptr);
+                } catch (...) {
+                    segments.erase(segments.begin(), segments.begin() + room);
+                    throw;
+                }
+                first = room;
+            }
+            --first;
+            segments[first] = to_iovec(memory);
+            owners[first] = o;
+            if (take_reference) { control::increment(o); }
+            bytes += memory.size();
+            return true;
+        }
+        template<typename T>
+        static iovec to_iovec(std::span<T> const memory) noexcept {
+            return {const_cast<std::byte *>(
+                            reinterpret_cast<std::byte const *>(memory.data())),
+                    memory.size()};
+        }
+    };
+
+
+}
@@ -0,0 +1,224 @@
+#pragma once
+
+
+#include <felspar/memory/shared_buffer.hpp>
+#include <felspar/memory/shared_vector.hpp>
+
+#include <algorithm>
+#include <bit>
+#include <mutex>
+#include <vector>
+
+
+namespace felspar::memory {
+
+
+    /// ## Recycling buffer pool
+    /**
+     * Hands out `shared_bytes` and `shared_buffer<std::byte>` whose memory is
+     * put back into the pool, rather than freed, when the last reference to it
+     * is released. Buffers are kept in buckets whose sizes are the powers of
+     * two from the smallest to the largest bucket size, and each bucket holds
+     * on to no more than `bucket_cap` free buffers. Once the buckets are warm,
+     * steady state traffic doesn't touch the upstream allocator at all.
+     *
+     * Requests larger than the largest bucket are allocated from upstream
+     * and returned to it when released.
+     *
+     * Unlike `shared_buffer<std::byte>::allocate`, pooled memory isn't
+     * initialised by default. A recycled buffer still holds whatever its
+     * previous user wrote into it, so ask for `contents::zeroed` when that
+     * matters.
+     *
+     * Buffers may be released from any thread, but the pool must outlive all
+     * of the buffers that it has handed out.
+     */
+    class buffer_pool final {
+        static constexpr std::size_t block_alignment = alignof(std::max_align_t);
+
+        /// ### Control block at the start of every pooled buffer
+        struct pooled_block final : public control {
+            buffer_pool *pool;
+            std::size_t bucket;
+
+            pooled_block(buffer_pool *p, std::size_t b) noexcept
+            : pool{p}, bucket{b} {}
+            ~pooled_block() = default;
+
+            void free() noexcept override {
+                auto *const p = pool;
+                auto const b = bucket;
+                void *const m = this;
+                this->~pooled_block();
+                p->recycle(m, b);
+            }
+        };
+        static constexpr std::size_t header =
+                block_size(sizeof(pooled_block), block_alignment);
+
+        /// Link stored in the memory of a buffer that is in a bucket
+        struct cached_buffer {
+            cached_buffer *next;
+        };
+        struct bucket_type {
+            std::mutex mutex = {};
+            cached_buffer *head = nullptr;
+            std::size_t count = {};
+        };
+
+        std::size_t smallest, largest, cap;
+        pmr::memory_resource *upstream;
+        std::vector<bucket_type> buckets;
+
+
+      public:
+        /// ### What a newly allocated buffer holds
+        enum class contents { unspecified, zeroed };
+
+
+        /// ### Construction
+        /**
+         * The bucket sizes are rounded up to powers of two.
+         */
+        explicit buffer_pool(
+                std::size_t const smallest_bucket = 4u << 10,
+                std::size_t const largest_bucket = 64u << 10,
+                std::size_t const bucket_cap = 64u,
+                pmr::memory_resource *const upstream =
+                        pmr::new_delete_resource())
+        : smallest{std::bit_ceil(std::max(smallest_bucket, std::size_t{1}))},
+          largest{std::bit_ceil(std::max(largest_bucket, smallest))},
+          cap{bucket_cap},
+          upstream{upstream},
+          buckets(std::countr_zero(largest) - std::countr_zero(smallest) + 1) {}
+        ~buffer_pool() {
+            for (std::size_t index{}; index < buckets.size(); ++index) {
+                auto *c = buckets[index].head;
+                while (c) {
+                    upstream->deallocate(
+                            std::exchange(c, c->next), allocation_bytes(index),
+                            block_alignment);
+                }
+            }
+        }
+
+        buffer_pool(buffer_pool const &) = delete;
+        buffer_pool &operator=(buffer_pool const &) = delete;
+
+
+        /// ### Allocation
+        [[nodiscard]] shared_bytes allocate_vector(
+                std::size_t const bytes,
+                contents const initial = contents::unspecified) {
+            if (bytes > largest) { return shared_bytes{bytes, upstream}; }
+            auto const made = take(bucket_for(bytes), bytes, initial);
+            shared_bytes v;
+            v.owner = made.first;
+            v.buffer = made.second;
+            return v;
+        }
+        [[nodiscard]] shared_buffer<std::byte> allocate_buffer(
+                std::size_t const bytes,
+                contents const initial = contents::unspecified) {
+            if (bytes > largest) {
+                return shared_buffer<std::byte>::allocate(
+                        bytes, std::byte{}, upstream);
+            }
+            auto const made = take(bucket_for(bytes), bytes, initial);
+            return shared_buffer<std::byte>{std::pair{
+                    std::unique_ptr<control>{made.first}, made.second}};
+        }
+
+
+        /// ### Warm up
+        /**
+         * Adds free buffers to the bucket used for allocations of `bytes`
+         * until it holds `count` of them, or is at its cap.
+         */
+        void preallocate(std::size_t const bytes, std::size_t const count) {
+            if (bytes > largest) { return; }
+            auto const index = bucket_for(bytes);
+            auto &b = buckets[index];
+            while (true) {
+                {
+                    std::scoped_lock _{b.mutex};
+                    if (b.count >= std::min(count, cap)) { return; }
+                }
+                recycle(upstream->allocate(
+                                allocation_bytes(index), block_alignment),
+                        index);
+            }
+        }
+
+
+        /// ### Queries
+        /// The size of the buffers in the bucket used for `bytes`
+        [[nodiscard]] std::size_t bucket_size(std::size_t const bytes) const {
+            return smallest << bucket_for(bytes);
+        }
+        [[nodiscard]] std::size_t bucket_cap() const noexcept { return cap; }
+        /// The number of free buffers held across all of the buckets
+        [[nodiscard]] std::size_t cached() {
+            std::size_t total{};
+            for (auto &b : buckets) {
+                std::scoped_lock _{b.mutex};
+                total += b.count;
+            }
+            return total;
+        }
+
+
+      private:
+        std::size_t bucket_for(std::size_t const bytes) const noexcept {
+            return static_cast<std::size_t>(
+                    std::countr_zero(std::bit_ceil(std::max(bytes, smallest)))
+                    - std::countr_zero(smallest));
+        }
+        std::size_t allocation_bytes(std::size_t const bucket) const noexcept {
+            return header + (smallest << bucket);
+        }
+
+        /// Return a new control block and the first `bytes` of the buffer
+        /// memory that follows it
+        std::pair<control *, std::span<std::byte>>
+                take(std::size_t const bucket,
+                     std::size_t const bytes,
+                     contents const initial) {
+            void *memory = nullptr;
+            {
+                auto &b = buckets[bucket];
+                std::scoped_lock _{b.mutex};
+                if (b.head) {
+                    memory = std::exchange(b.head, b.head->next);
+                    --b.count;
+                }
+            }
+            if (not memory) {
+                memory = upstream->allocate(
+                        allocation_bytes(bucket), block_alignment);
+            }
+            auto *const base = reinterpret_cast<std::byte *>(memory);
+            if (initial == contents::zeroed) {
+                std::fill_n(base + header, bytes, std::byte{});
+            }
+            return {new (base) pooled_block{this, bucket},
+                    {base + header, bytes}};
+        }
+        /// Put a buffer back into its bucket, or free it if the bucket is full
+        void recycle(void *const memory, std::size_t const bucket) noexcept {
+            {
+                auto &b = buckets[bucket];
+                std::scoped_lock _{b.mutex};
+                if (b.count < cap) {
+                    b.head = new (memory) cached_buffer{b.head};
+                    ++b.count;
+                    return;
+                }
+            }
+            upstream->deallocate(
+                    memory, allocation_bytes(bucket), block_alignment);
+        }
+    };
+
+
+}
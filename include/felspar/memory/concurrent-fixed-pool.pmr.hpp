@@ -0,0 +1,180 @@
+#pragma once
+
+
+#include <felspar/memory/fixed-pool.pmr.hpp>
+
+#include <atomic>
+#include <cstdint>
+
+
+namespace felspar::memory {
+
+
+    /// ## Thread safe fixed size pool
+    /**
+     * A version of the `fixed_pool` that can be shared between threads. Free
+     * blocks are kept on a lock-free stack whose head pointer is paired with a
+     * version counter that changes on every update, so a thread that was
+     * pre-empted part way through popping a block can't succeed if the head
+     * has been popped and pushed back in the meantime (the ABA problem).
+     *
+     * The upstream allocator is used for refills and for allocations larger
+     * than the pool's block size, and it must itself be thread safe.
+     *
+     * Blocks are never returned to the upstream allocator until the pool is
+     * destroyed, which is what makes it safe for a thread to read the link out
+     * of a block that another thread may have just popped.
+     *
+     * The head and its version are updated together with a double width
+     * compare and swap. Where the target has no such instruction, or the
+     * compiler doesn't use it inline (GCC passes 16 byte atomics to
+     * libatomic), the update goes through the atomics library, which may
+     * take a lock. `is_lock_free` reports which is happening.
+     */
+    class concurrent_fixed_pool : public pmr::memory_resource {
+        struct free_block {
+            std::atomic<free_block *> next;
+        };
+        struct chunk {
+            chunk *next;
+            std::size_t bytes;
+        };
+        struct alignas(2 * sizeof(void *)) tagged_head {
+            free_block *block;
+            std::uintptr_t version;
+        };
+        static constexpr std::size_t chunk_alignment =
+                alignof(std::max_align_t);
+        static constexpr std::size_t chunk_header =
+                block_size(sizeof(chunk), chunk_alignment);
+
+        void *do_allocate(std::size_t bytes, std::size_t alignment) override {
+            if (alignment > alignof(std::max_align_t)) {
+                detail::throw_overaligned_memory(
+                        alignment, std::source_location::current());
+            } else if (bytes <= max_size) {
+                auto head = pool.load(std::memory_order::acquire);
+                while (head.block
+                       and not pool.compare_exchange_weak(
+                               head,
+                               {head.block->next.load(
+                                        std::memory_order::relaxed),
+                                head.version + 1u},
+                               std::memory_order::acq_rel,
+                               std::memory_order::acquire)) {}
+                if (head.block) {
+                    return head.block;
+                } else {
+                    return refill();
+                }
+            } else {
+                return allocator->allocate(bytes);
+            }
+        }
+        void do_deallocate(void *p, std::size_t bytes, std::size_t) override {
+            if (bytes <= max_size) {
+                auto *const block = new (p) free_block{};
+                push(block, block);
+            } else {
+                allocator->deallocate(p, bytes);
+            }
+        }
+        bool do_is_equal(memory_resource const &other) const noexcept override {
+            return this == &other;
+        }
+
+        std::size_t max_size, block_bytes;
+        pmr::memory_resource *allocator;
+        pool_growth growth;
+        std::atomic<std::size_t> next_blocks;
+        std::atomic<chunk *> chunks = nullptr;
+        std::atomic<tagged_head> pool = tagged_head{};
+
+      public:
+        concurrent_fixed_pool(
+                std::size_t const max_size,
+                pmr::memory_resource *const allocator,
+                pool_growth const growth = {})
+        : max_size{max_size},
+          block_bytes{block_size(
+                  std::max(max_size, sizeof(free_block)), chunk_alignment)},
+          allocator{allocator},
+          growth{growth},
+          next_blocks{growth.first()} {}
+        ~concurrent_fixed_pool() {
+            auto *c = chunks.load(std::memory_order::acquire);
+            while (c) {
+                auto const bytes = c->bytes;
+                allocator->deallocate(
+                        std::exchange(c, c->next), bytes, chunk_alignment);
+            }
+        }
+
+        concurrent_fixed_pool(concurrent_fixed_pool const &) = delete;
+        concurrent_fixed_pool &operator=(concurrent_fixed_pool const &) = delete;
+
+
+        /// ### Whether the free list is updated without taking a lock
+        static constexpr bool is_always_lock_free =
+                std::atomic<tagged_head>::is_always_lock_free;
+        [[nodiscard]] bool is_lock_free() const noexcept {
+            return pool.is_lock_free();
+        }
+
+
+        /// ### Add blocks to the pool
+        /**
+         * Adds `blocks` more free blocks to the pool using a single upstream
+         * allocation. Typically used to warm the pool up before it is shared.
+         * The free blocks aren't counted, so unlike `fixed_pool::reserve`
+         * this always adds the blocks, whatever is already free.
+         */
+        void add_blocks(std::size_t const blocks) {
+            if (blocks) { push_chain(allocate_chunk(blocks), blocks); }
+        }
+
+
+      private:
+        /// Push a chain of linked blocks onto the free list
+        void push(free_block *const first, free_block *const last) noexcept {
+            auto head = pool.load(std::memory_order::relaxed);
+            do {
+                last->next.store(head.block, std::memory_order::relaxed);
+            } while (not pool.compare_exchange_weak(
+                    head, {first, head.version + 1u},
+                    std::memory_order::release, std::memory_order::relaxed));
+        }
+        /// Allocate a new chunk and link its blocks together
+        std::byte *allocate_chunk(std::size_t const blocks) {
+            std::size_t const bytes = chunk_header + blocks * block_bytes;
+            auto *const base = reinterpret_cast<std::byte *>(
+                    allocator->allocate(bytes, chunk_alignment));
+            auto *const c = new (base) chunk{
+                    chunks.load(std::memory_order::relaxed), bytes};
+            while (not chunks.compare_exchange_weak(
+                    c->next, c, std::memory_order::release,
+                    std::memory_order::relaxed)) {}
+            free_block *next = nullptr;
+            for (std::size_t index{blocks}; index; --index) {
+                next = new (base + chunk_header + (index - 1) * block_bytes)
+                        free_block{next};
+            }
+            return base + chunk_header;
+        }
+        void push_chain(std::byte *const first, std::size_t const blocks) {
+            push(reinterpret_cast<free_block *>(first),
+                 reinterpret_cast<free_block *>(
+                         first + (blocks - 1) * block_bytes));
+        }
+        /// Allocate a chunk, keeping the first block for the caller
+        void *refill() {
+            auto const blocks = next_blocks.load(std::memory_order::relaxed);
+            next_blocks.store(growth.after(blocks), std::memory_order::relaxed);
+            auto *const first = allocate_chunk(blocks);
+            if (blocks > 1u) { push_chain(first + block_bytes, blocks - 1u); }
+            return first;
+        }
+    };
+
+
+}
@@ -1,14 +1,20 @@
 #pragma once
 
 
+#include <felspar/memory/pmr.hpp>
 #include <felspar/memory/sizes.hpp>
 
 
+#include <algorithm>
 #include <atomic>
+#include <cstdint>
 #include <iterator>
 #include <memory>
+#include <mutex>
 #include <span>
+#include <type_traits>
 #include <utility>
+#include <vector>
 
 #ifndef assert
 #include <cassert>
@@ -18,15 +24,27 @@
 namespace felspar::memory {
 
 
+    template<typename T>
+    class array_control;
+    class retire_list;
+    namespace detail {
+        struct biased_owner;
+        struct control_record;
+        struct biased_thread;
+    }
+
+
     /// ## Control block for shared memory
     /**
      * A thread safe control block that supports atomic increment and decrements
      * on a counter. When the decrement reaches zero then the (virtual) `free()`
-     * function is called.
+     * function is called, unless there are weak references in which case the
+     * (virtual) `expire()` is called instead and `free()` waits for the last
+     * weak reference.
      */
     struct control {
         /// Use a virtual destructor for type erasure
-        virtual ~control() = default;
+        virtual ~control();
 
 
         /// ### Creation
@@ -41,35 +59,124 @@ namespace felspar::memory {
                 S item;
                 sub(S &&s) : item{std::move(s)} {}
                 ~sub() = default;
+                void expire() noexcept { release_item(item); }
                 void free() noexcept { delete this; }
             };
             auto made = std::make_unique<sub>(std::move(s));
             S *pitem = &made->item;
             return {std::move(made), pitem};
         }
+        /**
+         * As above, but the control block's memory comes from the memory
+         * resource and is given back to it when the count reaches zero.
+         */
+        template<typename S>
+        static std::pair<std::unique_ptr<control>, S *>
+                wrap_existing(S &&s, pmr::memory_resource *const resource) {
+            struct sub final : public control {
+                pmr::memory_resource *resource;
+                S item;
+                sub(pmr::memory_resource *r, S &&s)
+                : resource{r}, item{std::move(s)} {}
+                ~sub() = default;
+                void expire() noexcept { release_item(item); }
+                void free() noexcept {
+                    auto *const r = resource;
+                    void *const m = this;
+                    this->~sub();
+                    r->deallocate(m, sizeof(sub), alignof(sub));
+                }
+            };
+            void *const memory = resource->allocate(sizeof(sub), alignof(sub));
+            sub *made = nullptr;
+            try {
+                made = new (memory) sub{resource, std::move(s)};
+            } catch (...) {
+                resource->deallocate(memory, sizeof(sub), alignof(sub));
+                throw;
+            }
+            return {std::unique_ptr<control>(made), &made->item};
+        }
         /**
          * Allocate a chunk of memory. Return the control block together with a
          * span that encompasses the memory allocated. The initial ownership
-         * count will be one.
+         * count will be one. The control block and the memory are a single
+         * allocation from the memory resource.
          */
-        static auto
-                allocate(std::size_t const bytes, std::size_t const alignment) {
+        static auto allocate(
+                std::size_t const bytes,
+                std::size_t const alignment,
+                pmr::memory_resource *const resource =
+                        pmr::new_delete_resource()) {
             struct sub final : public control {
-                std::byte *memory;
-                sub(std::byte *m) noexcept : memory{m} {}
+                pmr::memory_resource *resource;
+                std::size_t bytes, alignment;
+                sub(pmr::memory_resource *r,
+                    std::size_t const b,
+                    std::size_t const a) noexcept
+                : resource{r}, bytes{b}, alignment{a} {}
                 ~sub() = default;
                 void free() noexcept {
-                    auto *const m = memory;
+                    auto *const r = resource;
+                    auto const b = bytes, a = alignment;
+                    void *const m = this;
                     this->~sub();
-                    delete[] m;
+                    r->deallocate(m, b, a);
                 }
             };
             std::size_t const data_offset = block_size(sizeof(sub), alignment);
-            std::byte *made = new std::byte[data_offset + bytes];
+            std::size_t const total = data_offset + bytes;
+            std::size_t const align = std::max(alignment, alignof(sub));
+            auto *const made = reinterpret_cast<std::byte *>(
+                    resource->allocate(total, align));
             return std::pair{
-                    std::unique_ptr<control>(new (made) sub{made}),
+                    std::unique_ptr<control>(
+                            new (made) sub{resource, total, align}),
                     std::span<std::byte>{made + data_offset, bytes}};
         }
+        /**
+         * Allocate an array of `count` items of type `T`, each a copy of `v`,
+         * in the same memory allocation as the control block. The items are
+         * destroyed when the ownership count reaches zero.
+         */
+        template<typename T, typename V = T>
+        static std::pair<std::unique_ptr<control>, std::span<T>>
+                allocate_array(
+                        std::size_t const count,
+                        V const &v = {},
+                        pmr::memory_resource *const resource =
+                                pmr::new_delete_resource()) {
+            auto *const block = array_control<T>::create(count, resource);
+            try {
+                block->append(count, v);
+            } catch (...) {
+                control *c = block;
+                decrement(c);
+                throw;
+            }
+            return {std::unique_ptr<control>(block), block->items()};
+        }
+
+        /**
+         * Allocate an array holding copies of the items, in the same memory
+         * allocation as the control block.
+         */
+        template<typename T>
+        static std::pair<std::unique_ptr<control>, std::span<T>> copy_array(
+                std::span<T const> const items,
+                pmr::memory_resource *const resource =
+                        pmr::new_delete_resource()) {
+            auto *const block =
+                    array_control<T>::create(items.size(), resource);
+            try {
+                block->append(items.begin(), items.end());
+            } catch (...) {
+                control *c = block;
+                decrement(c);
+                throw;
+            }
+            return {std::unique_ptr<control>(block), block->items()};
+        }
 
         /// ### Count management
         /**
@@ -81,31 +188,742 @@ namespace felspar::memory {
          *
          * [The memory ordering requirements are described by Raymond
          * Chen.](https://devblogs.microsoft.com/oldnewthing/20251015-00/?p=111686)
+         *
+         * Both take an optional number of references, so that many can be
+         * taken or released together with a single atomic operation.
          */
-        static control *increment(control *c) noexcept {
+        static control *
+                increment(control *c, std::size_t const n = 1u) noexcept {
             if (c) {
-                c->ownership_count.fetch_add(1, std::memory_order::release);
+                switch (c->mode.load(std::memory_order::relaxed)) {
+                case counting_mode::local:
+                    c->mode.store(
+                            counting_mode::atomic, std::memory_order::relaxed);
+                    [[fallthrough]];
+                case counting_mode::atomic:
+                    c->counter().fetch_add(n, std::memory_order::release);
+                    break;
+                case counting_mode::biased: c->biased_increment(n); break;
+                }
             }
             return c;
         }
-        static void decrement(control *&cr) noexcept {
+        static void decrement(control *&cr, std::size_t const n = 1u) noexcept {
             control *c = std::exchange(cr, nullptr);
             if (c
-                and c->ownership_count.fetch_sub(1, std::memory_order::acq_rel)
-                        == 1u) {
+                and c->mode.load(std::memory_order::relaxed)
+                        == counting_mode::biased) {
+                c->biased_decrement(n);
+            } else if (
+                    c
+                    and c->counter().fetch_sub(n, std::memory_order::acq_rel)
+                            == n) {
                 /**
                  * The call to `fetch_sub` returns the old value, not the value
                  * we set it to, so in practice the free needs to happen when
-                 * the old value was one.
+                 * the old value was the number being released.
                  */
+                c->destroy();
+            }
+        }
+
+
+        /// ### Ownership queries
+        /**
+         * The number of references to the block. If other threads hold
+         * references the answer may be out of date as soon as it is
+         * returned, but a count of one seen through a reference held by the
+         * caller can only go up if the caller makes a copy, or if a weak
+         * reference is locked.
+         *
+         * The owner of a biased block keeps its count privately. When another
+         * thread asks before the counts have been merged the owner's count
+         * can't be read, so the block is never reported as unique.
+         */
+        std::size_t use_count() const noexcept;
+        bool is_unique() const noexcept { return use_count() == 1u; }
+
+
+        /// ### Thread local counting
+        /**
+         * A newly created control block can be marked as only being used from
+         * the current thread. Whilst it is, `local_increment` and
+         * `local_decrement` update the count with a plain load and store
+         * rather than a locked read-modify-write. The first `increment` of the
+         * count, which is what happens when a thread safe handle to the memory
+         * is made, switches the block back to atomic counting for good, after
+         * which the local functions use atomic operations as well.
+         */
+        static control *start_local(control *c) noexcept {
+            if (c) {
+                c->mode.store(counting_mode::local, std::memory_order::relaxed);
+            }
+            return c;
+        }
+        static control *
+                local_increment(control *c, std::size_t const n = 1u) noexcept {
+            if (c
+                and c->mode.load(std::memory_order::relaxed)
+                        == counting_mode::local) {
+                auto &references = c->counter();
+                references.store(
+                        references.load(std::memory_order::relaxed) + n,
+                        std::memory_order::relaxed);
+                return c;
+            } else {
+                return increment(c, n);
+            }
+        }
+        static void local_decrement(
+                control *&cr, std::size_t const n = 1u) noexcept {
+            if (cr
+                and cr->mode.load(std::memory_order::relaxed)
+                        == counting_mode::local) {
+                control *c = std::exchange(cr, nullptr);
+                auto &references = c->counter();
+                auto const count = references.load(std::memory_order::relaxed);
+                references.store(count - n, std::memory_order::relaxed);
+                if (count == n) { c->destroy(); }
+            } else {
+                decrement(cr, n);
+            }
+        }
+
+
+        /// ### Weak references
+        /**
+         * A weak reference keeps the control block alive, but not what it
+         * manages. When the ownership count reaches zero the held items are
+         * destroyed straight away, but the control block, and any memory that
+         * was allocated alongside it, is only freed once the last weak
+         * reference has gone as well.
+         *
+         * `lock` takes an ownership reference if the ownership count hasn't
+         * yet reached zero, and returns `nullptr` if it has. Weak references
+         * to blocks using local counting must stay on the owning thread.
+         */
+        static control *weak_increment(control *c) noexcept {
+            if (c) { c->weak_count.fetch_add(1u, std::memory_order::relaxed); }
+            return c;
+        }
+        static void weak_decrement(control *&cr) noexcept {
+            control *c = std::exchange(cr, nullptr);
+            if (c
+                and c->weak_count.fetch_sub(1u, std::memory_order::acq_rel)
+                        == 1u) {
                 c->free();
             }
         }
+        static control *lock(control *c) noexcept;
+
+
+        /// ### Deferred reclamation
+        /**
+         * Normally the thread that releases the last reference frees the
+         * block there and then. A block can instead be set to be retired onto
+         * a `retire_list`, which costs the releasing thread a single atomic
+         * push, and it is then freed when the list is drained. This must be
+         * set before the block is shared with other threads, and the list
+         * must outlive the block.
+         *
+         * Only the release of the last ownership reference is deferred. If
+         * there are weak references then it is the drain that destroys the
+         * items, but the memory is freed by whichever thread releases the
+         * last weak reference.
+         *
+         * The list is kept in the block's separate record, the same one used
+         * for biased counting, which is allocated if the block doesn't have
+         * one yet.
+         */
+        static control *defer_reclamation(control *c, retire_list &list);
+
+
+        /// ### Biased counting
+        /**
+         * A newly created control block can instead be biased towards the
+         * thread that created it. That thread updates a count of its own with
+         * plain loads and stores, and all other threads use an atomic shared
+         * count. When the owning thread's count reaches zero the two counts are
+         * merged, after which every thread uses the shared count.
+         *
+         * If other threads release more references than they took, the shared
+         * count goes negative and the block is queued for the owning thread to
+         * merge. The owning thread merges its queue when it next releases a
+         * biased reference, when `merge_queued` is called, and when it exits.
+         * Blocks queued after the owning thread has exited are merged by the
+         * thread that queues them.
+         *
+         * `increment` and `decrement` work with all of the counting modes, so
+         * any handle type can share a biased block.
+         *
+         * The biased counts are kept in a separate record, so that blocks
+         * using the other modes don't pay for them. Whilst a block has a
+         * record its ownership count holds the address of the record.
+         */
+        static control *start_biased(control *c);
+        /// Merge any blocks queued for the calling thread
+        static void merge_queued() noexcept;
 
 
       private:
+        friend struct detail::biased_owner;
+        friend struct detail::control_record;
+        friend struct detail::biased_thread;
+
         virtual void free() noexcept = 0;
+        /// Destroy the held items early because there are weak references
+        virtual void expire() noexcept {}
+        /// Called when the ownership count reaches zero
+        void destroy() noexcept;
+        void destroy_now() noexcept {
+            if (weak_count.load(std::memory_order::acquire) == 1u) {
+                /// Without an ownership reference there's no way to make a
+                /// new weak reference, so nothing else can be waiting
+                free();
+            } else {
+                expire();
+                control *c = this;
+                weak_decrement(c);
+            }
+        }
+        /// Items held by `wrap_existing` are released by replacing them
+        template<typename S>
+        static void release_item(S &s) noexcept {
+            if constexpr (
+                    std::is_nothrow_default_constructible_v<S>
+                    and std::is_nothrow_move_assignable_v<S>) {
+                s = S{};
+            }
+        }
+
+        enum class counting_mode : std::uint8_t { atomic, local, biased };
+        /**
+         * In biased mode the record's count holds the shared count in units
+         * of `count_unit`, together with the merged and queued flags.
+         */
+        static constexpr std::size_t merged_flag = 1u, queued_flag = 2u,
+                                     count_unit = 4u;
+        static constexpr std::ptrdiff_t shared_count(std::size_t const v) {
+            return static_cast<std::ptrdiff_t>(v) >> 2;
+        }
+
+        detail::control_record *record() const noexcept {
+            return reinterpret_cast<detail::control_record *>(
+                    ownership_count.load(std::memory_order::relaxed));
+        }
+        /// Move the ownership count into a record if it isn't in one yet
+        detail::control_record *make_record();
+        /// The count used by the atomic and local modes
+        std::atomic<std::size_t> &counter() noexcept;
+        std::atomic<std::size_t> const &counter() const noexcept;
+        bool is_biased_owner() const noexcept;
+        void biased_increment(std::size_t n) noexcept;
+        void biased_decrement(std::size_t n) noexcept;
+        /// Fold the owner's count into the shared count
+        std::size_t merge(bool dequeue) noexcept;
+        /// Merge a block that has been taken off the queue
+        void release_queued() noexcept;
+
         std::atomic<std::size_t> ownership_count = 1u;
+        /// The weak references, plus one held by all of the owners together
+        std::atomic<std::uint32_t> weak_count = 1u;
+        std::atomic<counting_mode> mode = counting_mode::atomic;
+        /// Set when the ownership count holds the address of a record
+        bool recorded = false;
+
+        friend class retire_list;
+    };
+
+
+    /// ## Retired control blocks
+    /**
+     * A lock free list of control blocks whose last reference has been
+     * released, but which have not yet been freed. Any number of threads may
+     * retire blocks onto the list concurrently with one thread draining it.
+     * Anything left on the list is freed when the list is destroyed.
+     */
+    class retire_list final {
+        std::atomic<control *> head = nullptr;
+
+      public:
+        retire_list() = default;
+        retire_list(retire_list const &) = delete;
+        retire_list &operator=(retire_list const &) = delete;
+        ~retire_list() { drain(); }
+
+
+        /// ### Retire a block
+        void push(control *const c) noexcept;
+
+
+        /// ### Free the retired blocks
+        /// Returns the number of blocks that were freed
+        std::size_t drain() noexcept {
+            std::size_t count{};
+            for (auto *c = head.exchange(nullptr, std::memory_order::acquire);
+                 c; ++count) {
+                std::exchange(c, next(c))->destroy_now();
+            }
+            return count;
+        }
+
+
+        /// ### Queries
+        bool empty() const noexcept {
+            return head.load(std::memory_order::relaxed) == nullptr;
+        }
+
+
+      private:
+        static control *next(control *c) noexcept;
+    };
+
+
+    /// ## Reference counting policies
+    /**
+     * Used by the shared memory handles to choose how they update the count.
+     * Handles using `local_counting` must not be shared between threads, but
+     * they can be explicitly converted to handles using `atomic_counting`
+     * which can be. Handles using `biased_counting` may be shared between
+     * threads, but are cheapest to copy on the thread that allocated them.
+     */
+    struct atomic_counting {
+        static control *created(control *c) noexcept { return c; }
+        static control *
+                increment(control *c, std::size_t const n = 1u) noexcept {
+            return control::increment(c, n);
+        }
+        static void decrement(control *&c, std::size_t const n = 1u) noexcept {
+            control::decrement(c, n);
+        }
+    };
+    struct local_counting {
+        static control *created(control *c) noexcept {
+            return control::start_local(c);
+        }
+        static control *
+                increment(control *c, std::size_t const n = 1u) noexcept {
+            return control::local_increment(c, n);
+        }
+        static void decrement(control *&c, std::size_t const n = 1u) noexcept {
+            control::local_decrement(c, n);
+        }
+    };
+    struct biased_counting {
+        static control *created(control *c) {
+            return control::start_biased(c);
+        }
+        static control *
+                increment(control *c, std::size_t const n = 1u) noexcept {
+            return control::increment(c, n);
+        }
+        static void decrement(control *&c, std::size_t const n = 1u) noexcept {
+            control::decrement(c, n);
+        }
+    };
+
+
+    namespace detail {
+        /// The biased counting state for a thread
+        struct biased_owner {
+            std::atomic<std::size_t> references = 1u;
+            std::atomic<bool> pending = false;
+            std::mutex mutex = {};
+            bool alive = true;
+            std::vector<control *> queue = {};
+
+            void release() noexcept {
+                if (references.fetch_sub(1u, std::memory_order::acq_rel)
+                    == 1u) {
+                    delete this;
+                }
+            }
+            /// Queue a block for the owner to merge
+            void enqueue(control *const c) noexcept {
+                {
+                    std::scoped_lock _{mutex};
+                    if (alive) {
+                        queue.push_back(c);
+                        pending.store(true, std::memory_order::relaxed);
+                        return;
+                    }
+                }
+                c->release_queued();
+            }
+            std::vector<control *> take_queue() noexcept {
+                std::scoped_lock _{mutex};
+                pending.store(false, std::memory_order::relaxed);
+                return std::exchange(queue, {});
+            }
+        };
+        /// The counts and settings of a control block that needs them
+        struct control_record {
+            std::atomic<std::size_t> count;
+            /// Biased counting
+            std::size_t biased = {};
+            biased_owner *owner = nullptr;
+            /// Deferred reclamation
+            retire_list *retire_to = nullptr;
+            control *next_retired = nullptr;
+
+            ~control_record() {
+                if (owner) { owner->release(); }
+            }
+        };
+        struct biased_thread {
+            biased_owner *state = nullptr;
+
+            ~biased_thread() {
+                if (auto *const s = std::exchange(state, nullptr)) {
+                    std::vector<control *> queue;
+                    {
+                        std::scoped_lock _{s->mutex};
+                        s->alive = false;
+                        queue = std::exchange(s->queue, {});
+                    }
+                    for (auto *c : queue) { c->release_queued(); }
+                    s->release();
+                }
+            }
+        };
+        inline thread_local biased_thread biased_this_thread;
+    }
+
+
+    inline control::~control() {
+        if (recorded) { delete record(); }
+    }
+    inline detail::control_record *control::make_record() {
+        if (not recorded) {
+            auto *const r = new detail::control_record{
+                    ownership_count.load(std::memory_order::relaxed)};
+            ownership_count.store(
+                    reinterpret_cast<std::uintptr_t>(r),
+                    std::memory_order::relaxed);
+            recorded = true;
+        }
+        return record();
+    }
+    inline std::atomic<std::size_t> &control::counter() noexcept {
+        return recorded ? record()->count : ownership_count;
+    }
+    inline std::atomic<std::size_t> const &control::counter() const noexcept {
+        return recorded ? record()->count : ownership_count;
+    }
+    inline control *
+            control::defer_reclamation(control *const c, retire_list &list) {
+        if (c) { c->make_record()->retire_to = &list; }
+        return c;
+    }
+    inline void control::destroy() noexcept {
+        if (recorded and record()->retire_to) {
+            record()->retire_to->push(this);
+        } else {
+            destroy_now();
+        }
+    }
+    inline void retire_list::push(control *const c) noexcept {
+        auto *const r = c->record();
+        r->next_retired = head.load(std::memory_order::relaxed);
+        while (not head.compare_exchange_weak(
+                r->next_retired, c, std::memory_order::release,
+                std::memory_order::relaxed))
+            ;
+    }
+    inline control *retire_list::next(control *const c) noexcept {
+        return c->record()->next_retired;
+    }
+    inline control *control::start_biased(control *const c) {
+        if (c) {
+            auto &t = detail::biased_this_thread;
+            if (not t.state) { t.state = new detail::biased_owner; }
+            auto *const r = c->make_record();
+            r->biased = r->count.load(std::memory_order::relaxed);
+            r->count.store(0u, std::memory_order::relaxed);
+            r->owner = t.state;
+            t.state->references.fetch_add(1u, std::memory_order::relaxed);
+            c->mode.store(counting_mode::biased, std::memory_order::relaxed);
+        }
+        return c;
+    }
+    inline void control::merge_queued() noexcept {
+        auto *const s = detail::biased_this_thread.state;
+        if (s and s->pending.load(std::memory_order::relaxed)) {
+            for (auto *c : s->take_queue()) { c->release_queued(); }
+        }
+    }
+    inline bool control::is_biased_owner() const noexcept {
+        auto const *const r = record();
+        return r->owner == detail::biased_this_thread.state
+                and not(r->count.load(std::memory_order::relaxed)
+                        & merged_flag);
+    }
+    inline std::size_t control::use_count() const noexcept {
+        if (mode.load(std::memory_order::relaxed) != counting_mode::biased) {
+            return counter().load(std::memory_order::acquire);
+        }
+        auto const *const r = record();
+        auto const count = r->count.load(std::memory_order::acquire);
+        if (count & merged_flag) {
+            return static_cast<std::size_t>(shared_count(count));
+        } else {
+            auto const shared = shared_count(count);
+            if (is_biased_owner()) {
+                return static_cast<std::size_t>(
+                        static_cast<std::ptrdiff_t>(r->biased) + shared);
+            } else {
+                return static_cast<std::size_t>(
+                        std::max(shared + 1, std::ptrdiff_t{2}));
+            }
+        }
+    }
+    inline control *control::lock(control *const c) noexcept {
+        if (not c) { return nullptr; }
+        switch (c->mode.load(std::memory_order::relaxed)) {
+        case counting_mode::local: {
+            auto &references = c->counter();
+            auto const count = references.load(std::memory_order::relaxed);
+            if (count == 0u) { return nullptr; }
+            references.store(count + 1u, std::memory_order::relaxed);
+            return c;
+        }
+        case counting_mode::atomic: {
+            auto &references = c->counter();
+            auto count = references.load(std::memory_order::relaxed);
+            do {
+                if (count == 0u) { return nullptr; }
+            } while (not references.compare_exchange_weak(
+                    count, count + 1u, std::memory_order::acquire,
+                    std::memory_order::relaxed));
+            return c;
+        }
+        case counting_mode::biased:
+            auto *const r = c->record();
+            if (c->is_biased_owner()) {
+                ++r->biased;
+                return c;
+            }
+            /**
+             * Until the counts are merged the owning thread still holds a
+             * reference, and a unit added to the shared count before it
+             * merges is seen by the merge.
+             */
+            auto old = r->count.load(std::memory_order::relaxed);
+            do {
+                if ((old & merged_flag) and shared_count(old) <= 0) {
+                    return nullptr;
+                }
+            } while (not r->count.compare_exchange_weak(
+                    old, old + count_unit, std::memory_order::acquire,
+                    std::memory_order::relaxed));
+            return c;
+        }
+        return nullptr;
+    }
+    inline void control::biased_increment(std::size_t const n) noexcept {
+        auto *const r = record();
+        if (is_biased_owner()) {
+            r->biased += n;
+        } else {
+            r->count.fetch_add(n * count_unit, std::memory_order::relaxed);
+        }
+    }
+    inline void control::biased_decrement(std::size_t n) noexcept {
+        auto *const r = record();
+        if (is_biased_owner()) {
+            /**
+             * The owner may be releasing references that were taken on other
+             * threads, so any that are left over once the owner's count has
+             * reached zero come off the merged shared count.
+             */
+            auto const own = std::min(n, r->biased);
+            r->biased -= own;
+            n -= own;
+            if (r->biased) {
+                merge_queued();
+                return;
+            }
+            auto const now = merge(false);
+            if (n == 0u) {
+                if (shared_count(now) == 0 and not(now & queued_flag)) {
+                    destroy();
+                }
+                merge_queued();
+                return;
+            }
+        }
+        {
+            auto old = r->count.load(std::memory_order::relaxed);
+            std::size_t next;
+            do {
+                next = old - n * count_unit;
+                if (shared_count(next) < 0
+                    and not(old & (merged_flag | queued_flag))) {
+                    next |= queued_flag;
+                }
+            } while (not r->count.compare_exchange_weak(
+                    old, next, std::memory_order::acq_rel,
+                    std::memory_order::relaxed));
+            if ((next & queued_flag) and not(old & queued_flag)) {
+                r->owner->enqueue(this);
+            } else if (
+                    shared_count(next) == 0 and (next & merged_flag)
+                    and not(next & queued_flag)) {
+                destroy();
+            }
+        }
+    }
+    inline std::size_t control::merge(bool const dequeue) noexcept {
+        auto *const r = record();
+        auto const add = std::exchange(r->biased, 0u) * count_unit;
+        auto old = r->count.load(std::memory_order::relaxed);
+        std::size_t next;
+        do {
+            next = (old + add) | merged_flag;
+            if (dequeue) { next &= ~queued_flag; }
+        } while (not r->count.compare_exchange_weak(
+                old, next, std::memory_order::acq_rel,
+                std::memory_order::relaxed));
+        return next;
+    }
+    inline void control::release_queued() noexcept {
+        if (shared_count(merge(true)) == 0) { destroy(); }
+    }
+
+
+    /// ## Control block for a typed array
+    /**
+     * Holds an array of up to `capacity()` items of type `T` in the same
+     * memory allocation as the control block. Items are constructed at the end
+     * of the array by `append`, and when the ownership count reaches zero they
+     * are all destroyed and the memory is returned to the memory resource.
+     */
+    template<typename T>
+    class array_control final : public control {
+        pmr::memory_resource *resource;
+        std::size_t allocated_bytes, item_capacity, constructed = {};
+
+        array_control(
+                pmr::memory_resource *const r,
+                std::size_t const bytes,
+                std::size_t const capacity) noexcept
+        : resource{r}, allocated_bytes{bytes}, item_capacity{capacity} {}
+        ~array_control() = default;
+
+        void expire() noexcept override {
+            std::destroy_n(data(), std::exchange(constructed, 0u));
+        }
+        void free() noexcept override {
+            std::destroy_n(data(), constructed);
+            auto *const r = resource;
+            auto const bytes = allocated_bytes;
+            void *const m = this;
+            this->~array_control();
+            r->deallocate(m, bytes, block_alignment());
+        }
+
+
+      public:
+        /// ### Memory layout
+        /// The items start this many bytes after the start of the allocation
+        static constexpr std::size_t data_offset() noexcept {
+            return block_size(sizeof(array_control), alignof(T));
+        }
+        static constexpr std::size_t block_alignment() noexcept {
+            return std::max(alignof(array_control), alignof(T));
+        }
+        static constexpr std::size_t
+                allocation_bytes(std::size_t const capacity) noexcept {
+            return data_offset() + capacity * sizeof(T);
+        }
+
+
+        /// ### Creation
+        /// The control block has an ownership count of one and no items
+        static array_control *create(
+                std::size_t const capacity,
+                pmr::memory_resource *const resource) {
+            std::size_t const bytes = allocation_bytes(capacity);
+            return new (resource->allocate(bytes, block_alignment()))
+                    array_control{resource, bytes, capacity};
+        }
+        /**
+         * Create the control block at the start of memory that was allocated
+         * from the resource with `allocation_bytes(capacity)` and
+         * `block_alignment()`, and whose first `count` items have already been
+         * constructed. The control block takes ownership of the memory and of
+         * the items.
+         */
+        static array_control *adopt(
+                void *const memory,
+                std::size_t const capacity,
+                std::size_t const count,
+                pmr::memory_resource *const resource) noexcept {
+            auto *const block = new (memory) array_control{
+                    resource, allocation_bytes(capacity), capacity};
+            block->constructed = count;
+            return block;
+        }
+
+
+        /// ### Queries
+        T *data() noexcept {
+            return std::launder(reinterpret_cast<T *>(
+                    reinterpret_cast<std::byte *>(this) + data_offset()));
+        }
+        std::span<T> items() noexcept { return {data(), constructed}; }
+        std::size_t size() const noexcept { return constructed; }
+        std::size_t capacity() const noexcept { return item_capacity; }
+
+
+        /// ### Adding items
+        /**
+         * There must be enough capacity for the new items. If constructing an
+         * item throws then the array is left as it was.
+         */
+        template<typename V>
+        void append(std::size_t const count, V const &v) {
+            std::uninitialized_fill_n(data() + constructed, count, v);
+            constructed += count;
+        }
+        template<typename I>
+        void append(I const first, I const last) {
+            auto *const end =
+                    std::uninitialized_copy(first, last, data() + constructed);
+            constructed = static_cast<std::size_t>(end - data());
+        }
+
+
+        /// ### Removing items
+        /// Remove the first `count` items, moving the rest down to the front
+        void erase_front(std::size_t const count) noexcept
+            requires std::is_nothrow_move_assignable_v<T>
+        {
+            auto *const end =
+                    std::move(data() + count, data() + constructed, data());
+            std::destroy(end, data() + constructed);
+            constructed -= count;
+        }
+
+
+        /// ### Uninitialised capacity
+        /**
+         * Items of types that don't need constructing or destroying can be
+         * written straight into the spare capacity after the items, and are
+         * then added to the items by `commit`.
+         */
+        std::span<T> spare() noexcept
+            requires std::is_trivially_default_constructible_v<T>
+                and std::is_trivially_destructible_v<T>
+        {
+            return {data() + constructed, item_capacity - constructed};
+        }
+        void commit(std::size_t const count) noexcept
+            requires std::is_trivially_default_constructible_v<T>
+                and std::is_trivially_destructible_v<T>
+        {
+            constructed += count;
+        }
     };
 
 
@@ -3,6 +3,37 @@
 
 #include <cstddef>
 #include <source_location>
+#include <string>
+#include <system_error>
+
+
+namespace felspar::memory {
+
+
+    /// ## System errors
+    /**
+     * Thrown when an operating system call fails. Like the `felspar::stdexcept`
+     * types it carries the source location of the call that failed rather
+     * than formatting it into the message.
+     */
+    class system_error : public std::system_error {
+        std::source_location loc;
+
+      public:
+        system_error(
+                int const error,
+                std::string const &m,
+                std::source_location const &l =
+                        std::source_location::current())
+        : std::system_error{error, std::system_category(), m}, loc{l} {}
+
+        [[nodiscard]] std::source_location const &location() const noexcept {
+            return loc;
+        }
+    };
+
+
+}
 
 
 namespace felspar::memory::detail {
@@ -16,6 +47,8 @@ namespace felspar::memory::detail {
             throw_logic_error(char const *, std::source_location const &);
     [[noreturn]] void throw_overaligned_memory(
             std::size_t alignment, std::source_location const &);
+    [[noreturn]] void throw_system_error(
+            int error, char const *, std::source_location const &);
 
 
 }
@@ -3,33 +3,81 @@
 
 #include <felspar/memory/exceptions.hpp>
 #include <felspar/memory/pmr.hpp>
+#include <felspar/memory/sizes.hpp>
 
-#include <stdexcept>
-#include <string>
-#include <vector>
+#include <algorithm>
+#include <new>
+#include <utility>
 
 
 namespace felspar::memory {
 
 
+    /// ## Pool growth
+    /**
+     * Controls how many blocks a pool carves out of each allocation it makes
+     * from its upstream allocator when it runs out of free blocks. Each new
+     * chunk is `factor` times larger than the last one, up to a maximum.
+     * Every chunk has at least one block in it, whatever the settings.
+     */
+    struct pool_growth {
+        std::size_t initial_blocks = 1u;
+        std::size_t factor = 2u;
+        std::size_t maximum_blocks = 256u;
+
+        /// The number of blocks in the first chunk
+        constexpr std::size_t first() const noexcept {
+            return std::max(initial_blocks, std::size_t{1});
+        }
+        /// The number of blocks in the chunk after one of `blocks`
+        constexpr std::size_t after(std::size_t const blocks) const noexcept {
+            return std::max(
+                    std::min(blocks * factor, maximum_blocks), std::size_t{1});
+        }
+    };
+
+
     /// A pool of a single fixed size. Any allocation larger than this is given
     /// to the backing allocator
+    /**
+     * Blocks are carved out of larger chunks allocated from the backing
+     * allocator, and blocks that are returned to the pool are kept on a singly
+     * linked list whose links are stored inside the free blocks themselves.
+     * The chunks are only returned to the backing allocator when the pool is
+     * destroyed.
+     */
     class fixed_pool : public pmr::memory_resource {
+        struct free_block {
+            free_block *next;
+        };
+        struct chunk {
+            chunk *next;
+            std::size_t bytes;
+        };
+        static constexpr std::size_t chunk_alignment =
+                alignof(std::max_align_t);
+        static constexpr std::size_t chunk_header =
+                block_size(sizeof(chunk), chunk_alignment);
+
         void *do_allocate(std::size_t bytes, std::size_t alignment) override {
             if (alignment > alignof(std::max_align_t)) {
                 detail::throw_overaligned_memory(
                         alignment, std::source_location::current());
-            } else if (bytes <= max_size and not pool.empty()) {
-                std::byte *const v = pool.back();
-                pool.pop_back();
-                return v;
+            } else if (bytes <= max_size) {
+                if (not pool) [[unlikely]] {
+                    refill(next_blocks);
+                    next_blocks = growth.after(next_blocks);
+                }
+                --available;
+                return std::exchange(pool, pool->next);
             } else {
-                return allocator->allocate(std::max(max_size, bytes));
+                return allocator->allocate(bytes);
             }
         }
         void do_deallocate(void *p, std::size_t bytes, std::size_t) override {
             if (bytes <= max_size) {
-                pool.push_back(reinterpret_cast<std::byte *>(p));
+                pool = new (p) free_block{pool};
+                ++available;
             } else {
                 allocator->deallocate(p, bytes);
             }
@@ -38,23 +86,65 @@ namespace felspar::memory {
             return this == &other;
         }
 
-        std::size_t max_size;
+        std::size_t max_size, block_bytes;
         pmr::memory_resource *allocator;
-        std::vector<std::byte *> pool;
+        pool_growth growth;
+        std::size_t next_blocks, available = {};
+        free_block *pool = nullptr;
+        chunk *chunks = nullptr;
 
       public:
         fixed_pool(
                 std::size_t const max_size,
-                pmr::memory_resource *const allocator)
-        : max_size{max_size}, allocator{allocator} {}
+                pmr::memory_resource *const allocator,
+                pool_growth const growth = {})
+        : max_size{max_size},
+          block_bytes{block_size(
+                  std::max(max_size, sizeof(free_block)), chunk_alignment)},
+          allocator{allocator},
+          growth{growth},
+          next_blocks{growth.first()} {}
         ~fixed_pool() {
-            if (allocator) {
-                for (auto v : pool) { allocator->deallocate(v, max_size); }
+            while (chunks) {
+                auto const bytes = chunks->bytes;
+                allocator->deallocate(
+                        std::exchange(chunks, chunks->next), bytes,
+                        chunk_alignment);
             }
         }
 
         fixed_pool(fixed_pool const &) = delete;
         fixed_pool &operator=(fixed_pool const &) = delete;
+
+
+        /// ### The number of blocks available without an upstream allocation
+        [[nodiscard]] std::size_t free() const noexcept { return available; }
+
+
+        /// ### Make sure there are at least `blocks` free blocks
+        /**
+         * Any shortfall is allocated as a single chunk from the upstream
+         * allocator so that the blocks are contiguous in memory.
+         */
+        void reserve(std::size_t const blocks) {
+            if (available < blocks) { refill(blocks - available); }
+        }
+
+
+      private:
+        void refill(std::size_t const blocks) {
+            std::size_t const bytes = chunk_header + blocks * block_bytes;
+            auto *const base = reinterpret_cast<std::byte *>(
+                    allocator->allocate(bytes, chunk_alignment));
+            chunks = new (base) chunk{chunks, bytes};
+            /// Push the blocks in reverse so they're handed out in address
+            /// order
+            for (std::size_t index{blocks}; index; --index) {
+                pool = new (base + chunk_header + (index - 1) * block_bytes)
+                        free_block{pool};
+            }
+            available += blocks;
+        }
     };
 
 
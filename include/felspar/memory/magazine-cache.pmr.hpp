@@ -0,0 +1,264 @@
+#pragma once
+
+
+#include <felspar/memory/pmr.hpp>
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <utility>
+#include <vector>
+
+
+namespace felspar::memory {
+
+
+    namespace detail {
+        /// Cache identities are never re-used, so a thread can never mistake a
+        /// new cache for one that has since been destroyed
+        inline std::atomic<std::uint64_t> magazine_cache_identity{};
+    }
+
+
+    /// ## Thread caching front end for a memory resource
+    /**
+     * Each thread that uses the cache holds two "magazines", each of which can
+     * hold up to `M` free blocks of the cache's block size. Allocation and
+     * deallocation only touch the thread's own magazines until both of them
+     * are empty (or full), at which point a magazine is exchanged with a
+     * shared depot, under a lock, for a full (or empty) one. Only when the
+     * depot has no full magazines are blocks allocated from upstream.
+     *
+     * Requests larger than the block size, or over-aligned requests, go
+     * straight to the upstream allocator, which must be thread safe. Blocks
+     * are returned upstream when the cache is destroyed. Blocks held in the
+     * magazines of other threads at that point are not returned, so the
+     * upstream should be something like a `concurrent_fixed_pool` that
+     * reclaims all of its memory when it is destroyed.
+     *
+     * Blocks are asked for from upstream at exactly the cache's block size,
+     * so a pool of the same size serves them. Deallocation never throws. If
+     * the cache can't allocate a magazine to put a block in then the block is
+     * given straight back to upstream instead.
+     */
+    template<std::size_t M = 32>
+    class magazine_cache : public pmr::memory_resource {
+        static constexpr std::size_t block_alignment = alignof(std::max_align_t);
+
+        struct magazine {
+            magazine *next = nullptr;
+            std::size_t rounds = {};
+            std::array<void *, M> blocks;
+
+            bool empty() const noexcept { return rounds == 0u; }
+            bool full() const noexcept { return rounds == M; }
+            void *pop() noexcept { return blocks[--rounds]; }
+            void push(void *const p) noexcept { blocks[rounds++] = p; }
+        };
+
+        /// ### The depot shared by all threads
+        struct depot {
+            std::size_t block_bytes;
+            pmr::memory_resource *upstream;
+            std::mutex mutex = {};
+            magazine *loaded = nullptr, *empties = nullptr;
+
+            depot(std::size_t const b, pmr::memory_resource *const u)
+            : block_bytes{b}, upstream{u} {}
+            ~depot() {
+                release(std::exchange(loaded, nullptr));
+                release(std::exchange(empties, nullptr));
+            }
+
+            /// Give back an empty magazine in exchange for a loaded one
+            magazine *exchange_empty(magazine *const empty) {
+                std::scoped_lock _{mutex};
+                if (auto *const m = loaded) {
+                    loaded = std::exchange(m->next, nullptr);
+                    empty->next = std::exchange(empties, empty);
+                    return m;
+                } else {
+                    return nullptr;
+                }
+            }
+            /// Give back a full magazine in exchange for an empty one
+            /**
+             * Returns `nullptr`, keeping hold of the full magazine, if there
+             * is no empty magazine and a new one can't be allocated.
+             */
+            magazine *exchange_full(magazine *const full) noexcept {
+                {
+                    std::scoped_lock _{mutex};
+                    if (auto *const m = empties) {
+                        empties = std::exchange(m->next, nullptr);
+                        full->next = std::exchange(loaded, full);
+                        return m;
+                    }
+                }
+                auto *const m = new (std::nothrow) magazine;
+                if (m) {
+                    std::scoped_lock _{mutex};
+                    full->next = std::exchange(loaded, full);
+                }
+                return m;
+            }
+            /// Take back a magazine from a thread that is finished with it
+            void give_back(magazine *const m) {
+                std::scoped_lock _{mutex};
+                if (m->empty()) {
+                    m->next = std::exchange(empties, m);
+                } else {
+                    m->next = std::exchange(loaded, m);
+                }
+            }
+            /// Return all blocks in a chain of magazines upstream
+            void release(magazine *m) noexcept {
+                while (m) {
+                    while (not m->empty()) {
+                        upstream->deallocate(
+                                m->pop(), block_bytes, block_alignment);
+                    }
+                    delete std::exchange(m, m->next);
+                }
+            }
+        };
+
+        /// ### The magazines held by a thread
+        struct thread_magazines {
+            std::uint64_t identity;
+            std::weak_ptr<depot> owner;
+            magazine *loaded = nullptr, *previous = nullptr;
+
+            thread_magazines(std::uint64_t const i, std::weak_ptr<depot> o)
+            : identity{i}, owner{std::move(o)} {
+                auto first = std::make_unique<magazine>();
+                previous = new magazine;
+                loaded = first.release();
+            }
+            ~thread_magazines() {
+                if (auto d = owner.lock()) {
+                    d->give_back(loaded);
+                    d->give_back(previous);
+                } else {
+                    delete loaded;
+                    delete previous;
+                }
+            }
+        };
+        struct thread_state {
+            std::vector<std::unique_ptr<thread_magazines>> caches;
+            thread_magazines *last = nullptr;
+        };
+        static thread_state &this_thread() {
+            static thread_local thread_state state;
+            return state;
+        }
+
+        thread_magazines &magazines() {
+            auto &state = this_thread();
+            if (state.last and state.last->identity == identity) [[likely]] {
+                return *state.last;
+            }
+            for (auto &c : state.caches) {
+                if (c->identity == identity) { return *(state.last = c.get()); }
+            }
+            std::erase_if(state.caches, [](auto const &c) {
+                return c->owner.expired();
+            });
+            state.caches.push_back(
+                    std::make_unique<thread_magazines>(identity, shared));
+            return *(state.last = state.caches.back().get());
+        }
+
+        void *do_allocate(std::size_t bytes, std::size_t alignment) override {
+            if (bytes > block_bytes or alignment > block_alignment) {
+                return upstream->allocate(bytes, alignment);
+            }
+            auto &m = magazines();
+            if (not m.loaded->empty()) [[likely]] {
+                return m.loaded->pop();
+            } else if (not m.previous->empty()) {
+                std::swap(m.loaded, m.previous);
+                return m.loaded->pop();
+            } else if (auto *const full = shared->exchange_empty(m.previous)) {
+                m.previous = std::exchange(m.loaded, full);
+                return m.loaded->pop();
+            } else {
+                return upstream->allocate(block_bytes, block_alignment);
+            }
+        }
+        void do_deallocate(
+                void *p, std::size_t bytes, std::size_t alignment) override {
+            if (bytes > block_bytes or alignment > block_alignment) {
+                upstream->deallocate(p, bytes, alignment);
+                return;
+            }
+            thread_magazines *pm = nullptr;
+            try {
+                pm = &magazines();
+            } catch (std::bad_alloc const &) {
+                upstream->deallocate(p, block_bytes, block_alignment);
+                return;
+            }
+            auto &m = *pm;
+            if (not m.loaded->full()) [[likely]] {
+                m.loaded->push(p);
+            } else if (not m.previous->full()) {
+                std::swap(m.loaded, m.previous);
+                m.loaded->push(p);
+            } else if (
+                    auto *const empty = shared->exchange_full(m.previous)) {
+                m.previous = std::exchange(m.loaded, empty);
+                m.loaded->push(p);
+            } else {
+                upstream->deallocate(p, block_bytes, block_alignment);
+            }
+        }
+        bool do_is_equal(memory_resource const &other) const noexcept override {
+            return this == &other;
+        }
+
+        std::size_t block_bytes;
+        pmr::memory_resource *upstream;
+        std::uint64_t identity = detail::magazine_cache_identity.fetch_add(
+                1u, std::memory_order::relaxed);
+        std::shared_ptr<depot> shared =
+                std::make_shared<depot>(block_bytes, upstream);
+
+
+      public:
+        static constexpr std::size_t magazine_size = M;
+
+
+        /// ### Construction
+        magazine_cache(
+                std::size_t const block_size,
+                pmr::memory_resource *const upstream)
+        : block_bytes{block_size}, upstream{upstream} {}
+        ~magazine_cache() {
+            /// The calling thread's magazines are given back to the depot so
+            /// that their blocks are released along with the depot's
+            auto &state = this_thread();
+            if (state.last and state.last->identity == identity) {
+                state.last = nullptr;
+            }
+            std::erase_if(state.caches, [this](auto const &c) {
+                return c->identity == identity;
+            });
+        }
+
+        magazine_cache(magazine_cache const &) = delete;
+        magazine_cache &operator=(magazine_cache const &) = delete;
+
+
+        /// ### Queries
+        [[nodiscard]] std::size_t block_size() const noexcept {
+            return block_bytes;
+        }
+    };
+
+
+}
@@ -0,0 +1,156 @@
+#pragma once
+
+
+#include <felspar/memory/shared_buffer.hpp>
+#include <felspar/memory/shared_vector.hpp>
+
+#include <cerrno>
+#include <cstdint>
+#include <filesystem>
+#include <type_traits>
+
+#if __has_include(<sys/mman.h>) and __has_include(<unistd.h>)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+
+namespace felspar::memory {
+
+
+    /// ## Memory mapped files
+    /**
+     * A control block that owns a memory mapping of a whole file. The file is
+     * unmapped when the last buffer that refers to any part of it is released,
+     * so slices of a mapped file share the mapping without copying it.
+     */
+    class mapped_file final : public control {
+        void *address;
+        std::size_t length;
+
+        mapped_file(void *const a, std::size_t const l) noexcept
+        : address{a}, length{l} {}
+        ~mapped_file() = default;
+
+        void free() noexcept override {
+            ::munmap(address, length);
+            delete this;
+        }
+
+
+      public:
+        /// ### Expected access pattern
+        enum class access { normal, sequential, random, will_need };
+
+
+        /// ### Map a file
+        /**
+         * `S` may be any `shared_buffer<std::byte const, C>`, in which case
+         * the mapping is read only, or any `shared_buffer<std::byte, C>` or
+         * `shared_bytes`, which get a private writable mapping. Writes to a
+         * private mapping are not seen by the file or by other processes.
+         *
+         * An empty file gives an empty buffer.
+         */
+        template<typename S = shared_buffer<std::byte const>>
+        static S
+                map(std::filesystem::path const &path,
+                    access const pattern = access::normal,
+                    std::source_location const &loc =
+                            std::source_location::current()) {
+            using memory_type = decltype(std::declval<S &>().memory());
+            constexpr bool writable =
+                    not std::is_const_v<typename memory_type::element_type>;
+            int const fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+            if (fd < 0) {
+                detail::throw_system_error(
+                        errno, "Could not open the file to map", loc);
+            }
+            struct ::stat info;
+            if (::fstat(fd, &info) != 0) {
+                auto const error = errno;
+                ::close(fd);
+                detail::throw_system_error(
+                        error, "Could not find the size of the file", loc);
+            }
+            auto const bytes = static_cast<std::size_t>(info.st_size);
+            if (bytes == 0u) {
+                ::close(fd);
+                return S{};
+            }
+            void *const a = ::mmap(
+                    nullptr, bytes,
+                    writable ? PROT_READ | PROT_WRITE : PROT_READ,
+                    MAP_PRIVATE, fd, 0);
+            auto const error = errno;
+            ::close(fd);
+            if (a == MAP_FAILED) {
+                detail::throw_system_error(
+                        error, "Could not map the file", loc);
+            }
+            advise(std::span{static_cast<std::byte const *>(a), bytes},
+                   pattern);
+            mapped_file *block = nullptr;
+            try {
+                block = new mapped_file{a, bytes};
+            } catch (...) {
+                ::munmap(a, bytes);
+                throw;
+            }
+            S mapped;
+            mapped.buffer = {static_cast<std::byte *>(a), bytes};
+            mapped.owner = S::counting_type::created(block);
+            return mapped;
+        }
+
+
+        /// ### Change the expected access pattern
+        /**
+         * Tells the kernel how part of a mapping is going to be used. The
+         * memory is rounded out to whole pages. This is only a hint and so
+         * any failure is ignored.
+         */
+        static void advise(
+                std::span<std::byte const> const memory,
+                access const pattern) noexcept {
+            if (memory.empty()) { return; }
+            auto const page =
+                    static_cast<std::uintptr_t>(::sysconf(_SC_PAGESIZE));
+            auto const base = reinterpret_cast<std::uintptr_t>(memory.data());
+            auto const start = base & ~(page - 1u);
+            auto const end = base + memory.size();
+            ::madvise(
+                    reinterpret_cast<void *>(start), end - start,
+                    advice(pattern));
+        }
+
+
+      private:
+        static int advice(access const pattern) noexcept {
+            switch (pattern) {
+            case access::sequential: return MADV_SEQUENTIAL;
+            case access::random: return MADV_RANDOM;
+            case access::will_need: return MADV_WILLNEED;
+            case access::normal: break;
+            }
+            return MADV_NORMAL;
+        }
+    };
+
+
+    /// ### Map a file into a shared buffer
+    template<typename S = shared_buffer<std::byte const>>
+    inline S map_file(
+            std::filesystem::path const &path,
+            mapped_file::access const pattern = mapped_file::access::normal,
+            std::source_location const &loc =
+                    std::source_location::current()) {
+        return mapped_file::map<S>(path, pattern, loc);
+    }
+
+
+}
+
+
+#endif
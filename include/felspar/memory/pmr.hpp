@@ -23,8 +23,9 @@ namespace felspar {
 #ifdef FELSPAR_FORCE_PMR
 
 
-#include <typeinfo>
+#include <cstddef>
 #include <new>
+#include <typeinfo>
 
 
 namespace felspar::pmr {
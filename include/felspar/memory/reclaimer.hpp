@@ -0,0 +1,79 @@
+#pragma once
+
+
+#include <felspar/memory/control.hpp>
+
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+
+namespace felspar::memory {
+
+
+    /// ## Background reclaimer
+    /**
+     * Owns a `retire_list` and a thread that drains it every `interval`.
+     * Blocks set to be reclaimed by it with `control::defer_reclamation` are
+     * freed on the reclaimer's thread, in batches, rather than on the thread
+     * that releases their last reference.
+     *
+     * The reclaimer must outlive every block that is retired to it. When it
+     * is destroyed the thread is stopped and anything still retired is freed.
+     */
+    class reclaimer final {
+        retire_list list;
+        std::chrono::microseconds interval;
+        std::mutex mutex;
+        std::condition_variable signal;
+        bool stopping = false;
+        std::thread thread;
+
+      public:
+        explicit reclaimer(
+                std::chrono::microseconds const i =
+                        std::chrono::milliseconds{1})
+        : interval{i}, thread{[this]() { run(); }} {}
+        ~reclaimer() {
+            {
+                std::scoped_lock _{mutex};
+                stopping = true;
+            }
+            signal.notify_one();
+            thread.join();
+        }
+
+        reclaimer(reclaimer const &) = delete;
+        reclaimer &operator=(reclaimer const &) = delete;
+
+
+        /// ### The list that blocks are retired to
+        retire_list &retired() noexcept { return list; }
+
+
+        /// ### Set a block to be freed by this reclaimer
+        /// Allocates the block's record if it doesn't have one yet
+        control *adopt(control *const c) {
+            return control::defer_reclamation(c, list);
+        }
+
+
+        /// ### Free the retired blocks now
+        std::size_t drain() noexcept { return list.drain(); }
+
+
+      private:
+        void run() {
+            std::unique_lock lock{mutex};
+            while (not stopping) {
+                lock.unlock();
+                list.drain();
+                lock.lock();
+                signal.wait_for(lock, interval, [this]() { return stopping; });
+            }
+        }
+    };
+
+
+}
@@ -0,0 +1,170 @@
+#pragma once
+
+
+#include <felspar/memory/fixed-pool.pmr.hpp>
+
+#include <array>
+#include <cstdint>
+#include <deque>
+#include <span>
+#include <vector>
+
+
+namespace felspar::memory {
+
+
+    /// ## Size class segregated pool
+    /**
+     * Keeps a `fixed_pool` for each of a number of size classes and sends each
+     * allocation to the pool for the smallest class that can hold it. The
+     * class is found with a single table lookup. Allocations larger than the
+     * largest class, or that are over-aligned, go to the upstream allocator.
+     *
+     * The default classes run from 16 bytes to 4KB with four classes for each
+     * doubling in size, so no more than a fifth of a block is ever wasted
+     * above 64 bytes. Statistics are kept for each class so that the amount
+     * of internal fragmentation can be seen and the class table tuned.
+     *
+     * This pool is not thread safe.
+     */
+    class segregated_pool : public pmr::memory_resource {
+        static constexpr std::size_t granularity = alignof(std::max_align_t);
+
+      public:
+        /// ### Size class statistics
+        struct size_class_statistics {
+            std::size_t block_size;
+            /// Total number of allocations and deallocations
+            std::size_t allocations = {}, deallocations = {};
+            /// Total number of bytes that were asked for
+            std::size_t requested_bytes = {};
+
+            std::size_t live() const noexcept {
+                return allocations - deallocations;
+            }
+            /// The fraction of the handed out block memory that was not
+            /// requested
+            double fragmentation() const noexcept {
+                if (allocations) {
+                    return 1.0
+                            - double(requested_bytes)
+                            / double(allocations * block_size);
+                } else {
+                    return {};
+                }
+            }
+        };
+
+
+        /// ### The default size classes
+        static constexpr auto default_size_classes() {
+            std::array<std::size_t, 28> classes{};
+            std::size_t index{}, step{granularity};
+            for (std::size_t size{granularity}; size <= 4096u; size += step) {
+                classes[index++] = size;
+                if (size >= 64u and (size & (size - 1u)) == 0u) {
+                    step = size / 4u;
+                }
+            }
+            return classes;
+        }
+
+
+      private:
+        void *do_allocate(std::size_t bytes, std::size_t alignment) override {
+            if (bytes > largest or alignment > granularity) {
+                return upstream->allocate(bytes, alignment);
+            } else {
+                auto const sc = lookup[index_for(bytes)];
+                auto &stats = statistics_table[sc];
+                ++stats.allocations;
+                stats.requested_bytes += bytes;
+                return pools[sc].allocate(bytes, alignment);
+            }
+        }
+        void do_deallocate(
+                void *p, std::size_t bytes, std::size_t alignment) override {
+            if (bytes > largest or alignment > granularity) {
+                upstream->deallocate(p, bytes, alignment);
+            } else {
+                auto const sc = lookup[index_for(bytes)];
+                ++statistics_table[sc].deallocations;
+                pools[sc].deallocate(p, bytes, alignment);
+            }
+        }
+        bool do_is_equal(memory_resource const &other) const noexcept override {
+            return this == &other;
+        }
+
+        static constexpr std::size_t index_for(std::size_t const bytes) {
+            return (bytes + granularity - 1u) / granularity;
+        }
+
+        pmr::memory_resource *upstream;
+        std::size_t largest = {};
+        std::deque<fixed_pool> pools = {};
+        std::vector<size_class_statistics> statistics_table = {};
+        /// Maps the size in units of `granularity` to a size class
+        std::vector<std::uint8_t> lookup = {};
+
+
+      public:
+        /// ### Construction
+        /**
+         * The size classes must be in ascending order. Each class is rounded
+         * up to a multiple of the fundamental alignment.
+         */
+        segregated_pool(
+                std::span<std::size_t const> const classes,
+                pmr::memory_resource *const upstream,
+                pool_growth const growth = {},
+                std::source_location const &loc =
+                        std::source_location::current())
+        : upstream{upstream} {
+            for (auto const c : classes) {
+                auto const size = block_size(c, granularity);
+                if (size > largest) {
+                    largest = size;
+                    pools.emplace_back(size, upstream, growth);
+                    statistics_table.push_back({size});
+                } else if (size < largest) {
+                    detail::throw_logic_error(
+                            "Size classes must be in ascending order", loc);
+                }
+            }
+            if (pools.empty()) {
+                detail::throw_logic_error(
+                        "At least one size class is needed", loc);
+            } else if (pools.size() > 256u) {
+                detail::throw_length_error(
+                        "Too many size classes for the lookup table", loc);
+            }
+            lookup.resize(index_for(largest) + 1u);
+            for (std::size_t index{}, sc{}; index < lookup.size(); ++index) {
+                while (statistics_table[sc].block_size < index * granularity) {
+                    ++sc;
+                }
+                lookup[index] = static_cast<std::uint8_t>(sc);
+            }
+        }
+        explicit segregated_pool(
+                pmr::memory_resource *const upstream,
+                pool_growth const growth = {})
+        : segregated_pool{default_size_classes(), upstream, growth} {}
+
+        segregated_pool(segregated_pool const &) = delete;
+        segregated_pool &operator=(segregated_pool const &) = delete;
+
+
+        /// ### Queries
+        [[nodiscard]] std::size_t largest_class() const noexcept {
+            return largest;
+        }
+        [[nodiscard]] std::span<size_class_statistics const>
+                statistics() const noexcept {
+            return statistics_table;
+        }
+    };
+
+
+}
@@ -4,6 +4,7 @@
 #include <felspar/memory/control.hpp>
 #include <felspar/memory/exceptions.hpp>
 
+#include <concepts>
 #include <vector>
 
 
@@ -12,16 +13,37 @@ namespace felspar::memory {
 
     template<typename T>
     class accumulation_buffer;
+    class buffer_chain;
+    class buffer_pool;
+    class mapped_file;
     template<typename T>
     class shared_buffer_view;
+    template<typename T>
+    class unique_buffer;
+    template<typename T, typename C>
+    class weak_shared_buffer;
 
 
     /// ## A shared memory buffer
-    template<typename T>
+    /**
+     * The `C` parameter is the reference counting policy. The default,
+     * `atomic_counting`, allows copies of the buffer to be used from any
+     * thread. With `local_counting` all of the copies must stay on the thread
+     * that allocated the buffer, but copying them is cheaper. A buffer can be
+     * explicitly converted between the two.
+     */
+    template<typename T, typename C = atomic_counting>
     class shared_buffer final {
+        template<typename, typename>
+        friend class shared_buffer;
         friend class accumulation_buffer<T>;
+        friend class buffer_chain;
+        friend class buffer_pool;
+        friend class mapped_file;
         friend class shared_buffer_view<T>;
         friend class shared_buffer_view<T const>;
+        friend class unique_buffer<T>;
+        friend class weak_shared_buffer<T, C>;
         using vector_type = std::vector<T>;
         using control_type = control;
         using buffer_type = std::span<T>;
@@ -32,47 +54,78 @@ namespace felspar::memory {
         explicit shared_buffer(
                 std::pair<std::unique_ptr<control_type>, vector_type *> alloc)
         : buffer{alloc.second->data(), alloc.second->size()},
-          owner{alloc.first.release()} {}
+          owner{C::created(alloc.first.release())} {}
+        explicit shared_buffer(
+                std::pair<std::unique_ptr<control_type>, buffer_type> alloc)
+        : buffer{alloc.second}, owner{C::created(alloc.first.release())} {}
         shared_buffer(control_type *o, buffer_type b)
-        : buffer{b}, owner{control_type::increment(o)} {}
+        : buffer{b}, owner{C::increment(o)} {}
 
 
       public:
         using value_type = T;
         using view_type = shared_buffer_view<T>;
+        using counting_type = C;
 
 
         /// ### Construction, destruction and assignment
         shared_buffer() {}
         shared_buffer(shared_buffer const &sb)
-        : buffer{sb.buffer}, owner{control_type::increment(sb.owner)} {}
+        : buffer{sb.buffer}, owner{C::increment(sb.owner)} {}
         shared_buffer &operator=(shared_buffer const &sb) {
             buffer = sb.buffer;
-            control_type::decrement(owner);
-            owner = control_type::increment(sb.owner);
+            C::decrement(owner);
+            owner = C::increment(sb.owner);
             return *this;
         }
         shared_buffer(shared_buffer &&sb)
         : buffer{std::exchange(sb.buffer, {})},
           owner{std::exchange(sb.owner, {})} {}
         shared_buffer &operator=(shared_buffer &&sb) {
-            control_type::decrement(owner);
+            C::decrement(owner);
             owner = std::exchange(sb.owner, {});
             buffer = std::exchange(sb.buffer, {});
             return *this;
         }
-        ~shared_buffer() { control_type::decrement(owner); }
+        ~shared_buffer() { C::decrement(owner); }
+
+        /// #### Conversion between counting policies
+        template<typename O>
+        explicit shared_buffer(shared_buffer<T, O> const &sb)
+            requires(not std::same_as<C, O>)
+        : buffer{sb.buffer}, owner{C::increment(sb.owner)} {}
 
 
         /// ### Allocation
+        /**
+         * The control block and the items are placed in a single memory
+         * allocation. A buffer made using `wrap` keeps the vector's own memory
+         * and so needs a separate allocation for the control block.
+         *
+         * When a memory resource is given the control block is allocated from
+         * it, and returned to it when the last reference is released.
+         */
         template<typename V = value_type>
         static shared_buffer allocate(std::size_t const count, V &&v = {}) {
-            return shared_buffer{control_type::wrap_existing(
-                    vector_type(count, std::forward<V>(v)))};
+            return shared_buffer{
+                    control_type::allocate_array<value_type>(count, v)};
+        }
+        template<typename V>
+        static shared_buffer allocate(
+                std::size_t const count,
+                V &&v,
+                pmr::memory_resource *const resource) {
+            return shared_buffer{control_type::allocate_array<value_type>(
+                    count, v, resource)};
         }
         static shared_buffer wrap(vector_type v) {
             return shared_buffer{control_type::wrap_existing(std::move(v))};
         }
+        static shared_buffer
+                wrap(vector_type v, pmr::memory_resource *const resource) {
+            return shared_buffer{
+                    control_type::wrap_existing(std::move(v), resource)};
+        }
 
 
         /// ### Information about the buffer
@@ -119,6 +172,23 @@ namespace felspar::memory {
 
         value_type const *data() const noexcept { return buffer.data(); }
 
+        /// #### Copy on write
+        /**
+         * Return the memory for writing to. If this buffer holds the only
+         * reference to it then the memory is returned as it is, otherwise the
+         * items are first copied into a new allocation from the resource that
+         * only this buffer refers to.
+         */
+        buffer_type make_writable(
+                pmr::memory_resource *const resource =
+                        pmr::new_delete_resource()) {
+            if (owner and not owner->is_unique()) {
+                *this = shared_buffer{control_type::copy_array<value_type>(
+                        const_buffer_type{buffer}, resource)};
+            }
+            return buffer;
+        }
+
 
         /// ### Implicit conversions
         operator std::span<value_type>() noexcept { return buffer; }
@@ -129,11 +199,62 @@ namespace felspar::memory {
         shared_buffer first(std::size_t const items) {
             return {owner, buffer.first(items)};
         }
+        /**
+         * Return consecutive slices from the start of the buffer with the
+         * requested sizes. The references for all of the slices are taken
+         * together.
+         */
+        std::vector<shared_buffer>
+                split(std::span<std::size_t const> const sizes,
+                      std::source_location const &loc =
+                              std::source_location::current()) {
+            return slice(owner, buffer, sizes, loc);
+        }
+
+
+        /// ### Releasing many buffers
+        /**
+         * Releases all of the buffers, and adjacent buffers that share the
+         * same control block release their references together.
+         */
+        static void release(std::span<shared_buffer> const buffers) noexcept {
+            for (std::size_t index{}; index < buffers.size();) {
+                control_type *o = buffers[index].owner;
+                std::size_t count{};
+                for (; index < buffers.size() and buffers[index].owner == o;
+                     ++index, ++count) {
+                    buffers[index].owner = nullptr;
+                    buffers[index].buffer = {};
+                }
+                C::decrement(o, count);
+            }
+        }
 
 
       private:
         buffer_type buffer;
         control_type *owner = nullptr;
+
+        static std::vector<shared_buffer>
+                slice(control_type *const o,
+                      buffer_type const b,
+                      std::span<std::size_t const> const sizes,
+                      std::source_location const &loc) {
+            std::vector<shared_buffer> slices(sizes.size());
+            std::size_t offset{};
+            for (std::size_t index{}; index < sizes.size(); ++index) {
+                if (sizes[index] > b.size() - offset) {
+                    detail::throw_logic_error("Buffer overrun", loc);
+                }
+                slices[index].buffer = b.subspan(offset, sizes[index]);
+                offset += sizes[index];
+            }
+            if (o and not slices.empty()) {
+                C::increment(o, slices.size());
+                for (auto &s : slices) { s.owner = o; }
+            }
+            return slices;
+        }
     };
 
 
@@ -174,4 +295,82 @@ namespace felspar::memory {
     shared_buffer_view(shared_buffer<T>) -> shared_buffer_view<T>;
 
 
+    /// ## A weak reference to a shared memory buffer
+    /**
+     * Doesn't keep the items in the buffer alive, but for as long as some
+     * `shared_buffer` still refers to them `lock` returns a new
+     * `shared_buffer` for the same memory. Once they have gone `lock` returns
+     * an empty buffer.
+     *
+     * Where the items share a memory allocation with the control block, as
+     * they do for `shared_buffer::allocate`, the items are destroyed when the
+     * last `shared_buffer` goes but the memory is only returned once the
+     * weak references have gone too.
+     */
+    template<typename T, typename C = atomic_counting>
+    class weak_shared_buffer final {
+      public:
+        using value_type = T;
+        using buffer_type = std::span<T>;
+        using control_type = control;
+        using shared_type = shared_buffer<T, C>;
+
+
+        /// ### Construction, destruction and assignment
+        weak_shared_buffer() {}
+        weak_shared_buffer(shared_type const &sb)
+        : buffer{sb.buffer}, owner{control_type::weak_increment(sb.owner)} {}
+        weak_shared_buffer(weak_shared_buffer const &wb)
+        : buffer{wb.buffer}, owner{control_type::weak_increment(wb.owner)} {}
+        weak_shared_buffer &operator=(weak_shared_buffer const &wb) {
+            buffer = wb.buffer;
+            control_type::weak_decrement(owner);
+            owner = control_type::weak_increment(wb.owner);
+            return *this;
+        }
+        weak_shared_buffer(weak_shared_buffer &&wb)
+        : buffer{std::exchange(wb.buffer, {})},
+          owner{std::exchange(wb.owner, {})} {}
+        weak_shared_buffer &operator=(weak_shared_buffer &&wb) {
+            control_type::weak_decrement(owner);
+            owner = std::exchange(wb.owner, {});
+            buffer = std::exchange(wb.buffer, {});
+            return *this;
+        }
+        ~weak_shared_buffer() { control_type::weak_decrement(owner); }
+
+
+        /// ### Queries
+        /// True once the items are no longer available
+        bool expired() const noexcept {
+            return not owner or owner->use_count() == 0u;
+        }
+        /// The size of the buffer the weak reference was made from
+        auto size() const noexcept { return buffer.size(); }
+
+
+        /// ### Access to the items
+        shared_type lock() const noexcept {
+            shared_type sb;
+            if (auto *const c = control_type::lock(owner)) {
+                sb.buffer = buffer;
+                sb.owner = c;
+            }
+            return sb;
+        }
+
+
+      private:
+        buffer_type buffer;
+        control_type *owner = nullptr;
+    };
+
+
+    /// ### Type aliases
+    template<typename T>
+    using local_shared_buffer = shared_buffer<T, local_counting>;
+    template<typename T>
+    using biased_shared_buffer = shared_buffer<T, biased_counting>;
+
+
 }
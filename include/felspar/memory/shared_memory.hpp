@@ -0,0 +1,244 @@
+#pragma once
+
+
+#include <felspar/memory/shared_vector.hpp>
+
+#include <atomic>
+#include <cerrno>
+#include <cstdint>
+
+#if __has_include(<sys/mman.h>) and __has_include(<unistd.h>)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#ifndef __linux__
+#include <string>
+#endif
+
+
+namespace felspar::memory {
+
+
+    /// ## Shared memory segments
+    /**
+     * A `shared_bytes` whose memory is a shared memory segment that other
+     * processes can map, so that data can be handed between processes without
+     * being copied. The segment is created using `memfd_create` on Linux and
+     * an immediately unlinked `shm_open` object elsewhere.
+     *
+     * `export_descriptor` describes where a vector is in its segment, and
+     * after the file descriptor has been passed to another process (for
+     * example using `SCM_RIGHTS` or by forking) `import_descriptor` maps the
+     * same memory there.
+     *
+     * Within a process handles are counted by a local control block as usual.
+     * The segment starts with a header holding a count of the mappings of it
+     * across all processes, which `mappings` returns. A process's mapping is
+     * released when the last of its handles into the segment is.
+     */
+    class shared_memory final : public control {
+        struct header {
+            std::uint64_t magic;
+            std::atomic<std::size_t> mappings;
+            std::size_t bytes;
+        };
+        static_assert(
+                std::atomic<std::size_t>::is_always_lock_free,
+                "The count must be address free to work across processes");
+        static constexpr std::uint64_t segment_magic = 0x6665'6c73'7061'7231;
+        static constexpr std::size_t data_offset =
+                block_size(sizeof(header), alignof(std::max_align_t));
+
+        int fd;
+        header *segment;
+        std::size_t length;
+
+        shared_memory(int const f, void *const a, std::size_t const l) noexcept
+        : fd{f}, segment{static_cast<header *>(a)}, length{l} {}
+        ~shared_memory() = default;
+
+        void free() noexcept override {
+            segment->mappings.fetch_sub(1u, std::memory_order::acq_rel);
+            ::munmap(segment, length);
+            ::close(fd);
+            delete this;
+        }
+
+
+      public:
+        /// ### Describes a vector in a segment
+        struct descriptor {
+            /// The segment's file descriptor, owned by the segment
+            int fd;
+            /// Where the vector starts within the segment's data
+            std::size_t offset;
+            std::size_t size;
+        };
+
+
+        /// ### Allocate a new segment
+        [[nodiscard]] static shared_bytes allocate(
+                std::size_t const bytes,
+                std::source_location const &loc =
+                        std::source_location::current()) {
+            int const f = create(loc);
+            if (::ftruncate(f, static_cast<::off_t>(data_offset + bytes))
+                != 0) {
+                auto const error = errno;
+                ::close(f);
+                detail::throw_system_error(
+                        error, "Could not size the shared memory segment",
+                        loc);
+            }
+            auto *const block = map(f, data_offset + bytes, loc);
+            new (block->segment) header{segment_magic, 1u, bytes};
+            return block->vector(0u, bytes);
+        }
+
+
+        /// ### Share a vector with another process
+        /**
+         * Throws a `logic_error` if the vector's memory isn't in a shared
+         * memory segment. The file descriptor remains owned by the segment,
+         * and so is only valid for as long as a handle into the segment is
+         * kept.
+         */
+        [[nodiscard]] static descriptor export_descriptor(
+                shared_bytes const &sv,
+                std::source_location const &loc =
+                        std::source_location::current()) {
+            auto const *const block = segment_of(sv, loc);
+            auto const *const data =
+                    reinterpret_cast<std::byte const *>(block->segment)
+                    + data_offset;
+            return {block->fd, static_cast<std::size_t>(sv.data() - data),
+                    sv.size()};
+        }
+        /**
+         * Maps the segment described into this process. The file descriptor
+         * in the descriptor is duplicated, so the caller still owns it.
+         */
+        [[nodiscard]] static shared_bytes import_descriptor(
+                descriptor const &d,
+                std::source_location const &loc =
+                        std::source_location::current()) {
+            int const f = ::fcntl(d.fd, F_DUPFD_CLOEXEC, 0);
+            if (f < 0) {
+                detail::throw_system_error(
+                        errno, "Could not duplicate the segment descriptor",
+                        loc);
+            }
+            struct ::stat info;
+            if (::fstat(f, &info) != 0) {
+                auto const error = errno;
+                ::close(f);
+                detail::throw_system_error(
+                        error, "Could not find the size of the segment", loc);
+            }
+            auto const length = static_cast<std::size_t>(info.st_size);
+            if (length < data_offset) {
+                ::close(f);
+                detail::throw_logic_error(
+                        "The descriptor isn't for a shared memory segment",
+                        loc);
+            }
+            auto *const block = map(f, length, loc);
+            char const *error = nullptr;
+            if (block->segment->magic != segment_magic
+                or block->segment->bytes != length - data_offset) {
+                error = "The descriptor isn't for a shared memory segment";
+            } else if (
+                    d.offset > block->segment->bytes
+                    or d.size > block->segment->bytes - d.offset) {
+                error = "The descriptor is outside of the segment";
+            }
+            if (error) {
+                /// The mapping isn't counted in the header yet
+                ::munmap(block->segment, block->length);
+                ::close(block->fd);
+                delete block;
+                detail::throw_logic_error(error, loc);
+            }
+            block->segment->mappings.fetch_add(
+                    1u, std::memory_order::relaxed);
+            return block->vector(d.offset, d.size);
+        }
+
+
+        /// ### The number of mappings of the segment in all processes
+        [[nodiscard]] static std::size_t mappings(
+                shared_bytes const &sv,
+                std::source_location const &loc =
+                        std::source_location::current()) {
+            return segment_of(sv, loc)->segment->mappings.load(
+                    std::memory_order::acquire);
+        }
+
+
+      private:
+        static int create(std::source_location const &loc) {
+#ifdef __linux__
+            int const f = ::memfd_create("felspar-memory", MFD_CLOEXEC);
+#else
+            static std::atomic<unsigned> sequence = {};
+            auto const name = "/felspar-memory-" + std::to_string(::getpid())
+                    + "-" + std::to_string(++sequence);
+            int const f =
+                    ::shm_open(name.c_str(), O_RDWR | O_CREAT | O_EXCL, 0600);
+            if (f >= 0) { ::shm_unlink(name.c_str()); }
+#endif
+            if (f < 0) {
+                detail::throw_system_error(
+                        errno, "Could not create a shared memory segment",
+                        loc);
+            }
+            return f;
+        }
+        /// Map the segment, taking ownership of the file descriptor
+        static shared_memory *
+                map(int const f,
+                    std::size_t const length,
+                    std::source_location const &loc) {
+            void *const a = ::mmap(
+                    nullptr, length, PROT_READ | PROT_WRITE, MAP_SHARED, f, 0);
+            if (a == MAP_FAILED) {
+                auto const error = errno;
+                ::close(f);
+                detail::throw_system_error(
+                        error, "Could not map the shared memory segment", loc);
+            }
+            try {
+                return new shared_memory{f, a, length};
+            } catch (...) {
+                ::munmap(a, length);
+                ::close(f);
+                throw;
+            }
+        }
+        static shared_memory const *segment_of(
+                shared_bytes const &sv, std::source_location const &loc) {
+            auto const *const block =
+                    dynamic_cast<shared_memory const *>(sv.owner);
+            if (not block) {
+                detail::throw_logic_error(
+                        "The memory isn't in a shared memory segment", loc);
+            }
+            return block;
+        }
+        /// Hand the new control block's reference to a vector
+        shared_bytes vector(std::size_t const offset, std::size_t const size) {
+            shared_bytes sv;
+            sv.buffer = {reinterpret_cast<std::byte *>(segment) + data_offset
+                                 + offset,
+                         size};
+            sv.owner = shared_bytes::counting_type::created(this);
+            return sv;
+        }
+    };
+
+
+}
+
+
+#endif
@@ -1,23 +1,48 @@
 #pragma once
 
 
+#include <felspar/memory/exceptions.hpp>
 #include <felspar/memory/shared_view.hpp>
 
+#include <algorithm>
+#include <concepts>
+#include <vector>
+
 
 namespace felspar::memory {
 
 
+    class buffer_chain;
+    class buffer_pool;
+    class mapped_file;
+    template<typename T>
+    class unique_buffer;
+    template<typename T, typename C>
+    class weak_shared_vector;
+
+
     /// ### Shared memory vector
     /**
      * Allows for memory allocations of a vector like type to be shared between
      * instances. Access into the held data is not thread safe, but updates to
      * the shared counts are, so immutable data may be safely shared between
      * `shared_vector` instances.
+     *
+     * As with `shared_buffer`, the `C` parameter chooses the reference
+     * counting policy, and `local_counting` vectors must stay on one thread.
      */
-    template<typename T>
+    template<typename T, typename C>
     class shared_vector final {
         template<typename Tt>
         friend class shared_view;
+        template<typename, typename>
+        friend class shared_vector;
+        friend class buffer_chain;
+        friend class buffer_pool;
+        friend class mapped_file;
+        friend class shared_memory;
+        friend class unique_buffer<T>;
+        friend class weak_shared_vector<T, C>;
 
         typename shared_view<T>::span_type buffer;
         typename shared_view<T>::control_type *owner = nullptr;
@@ -25,20 +50,30 @@ namespace felspar::memory {
         shared_vector(
                 typename shared_view<T>::span_type s,
                 typename shared_view<T>::control_type *o)
-        : buffer{s}, owner{control_type::increment(o)} {}
+        : buffer{s}, owner{C::increment(o)} {}
 
       public:
         using view_type = shared_view<T>;
         using span_type = typename view_type::span_type;
         using const_span_type = typename view_type::const_span_type;
         using control_type = typename view_type::control_type;
+        using counting_type = C;
 
         /// ### Constructors
         shared_vector() {}
         explicit shared_vector(std::size_t const elements) {
             auto created =
                     control_type::allocate(elements * sizeof(T), alignof(T));
-            owner = created.first.release();
+            owner = C::created(created.first.release());
+            buffer = created.second;
+        }
+        /// The memory is allocated from, and returned to, the resource
+        shared_vector(
+                std::size_t const elements,
+                pmr::memory_resource *const resource) {
+            auto created = control_type::allocate(
+                    elements * sizeof(T), alignof(T), resource);
+            owner = C::created(created.first.release());
             buffer = created.second;
         }
 
@@ -46,8 +81,14 @@ namespace felspar::memory {
         shared_vector(shared_vector const &sb)
         : shared_vector{sb.buffer, sb.owner} {}
 
+        /// Conversion between counting policies
+        template<typename O>
+        explicit shared_vector(shared_vector<T, O> const &sv)
+            requires(not std::same_as<C, O>)
+        : shared_vector{sv.buffer, sv.owner} {}
+
         /// Destructor
-        ~shared_vector() { control_type::decrement(owner); }
+        ~shared_vector() { C::decrement(owner); }
 
         /// ### Manipulation
         /**
@@ -60,6 +101,51 @@ namespace felspar::memory {
             buffer = buffer.subspan(elements);
             return {consumed, owner};
         }
+        /**
+         * Consume consecutive slices from the front of the vector with the
+         * requested sizes. The references for all of the slices are taken
+         * together.
+         */
+        std::vector<shared_vector> consume_split(
+                std::span<std::size_t const> const sizes,
+                std::source_location const &loc =
+                        std::source_location::current()) {
+            std::size_t total{};
+            for (auto const size : sizes) {
+                if (size > buffer.size() - total) {
+                    detail::throw_logic_error("Buffer overrun", loc);
+                }
+                total += size;
+            }
+            std::vector<shared_vector> slices(sizes.size());
+            for (std::size_t index{}; index < sizes.size(); ++index) {
+                slices[index].buffer = buffer.first(sizes[index]);
+                buffer = buffer.subspan(sizes[index]);
+            }
+            if (owner and not slices.empty()) {
+                C::increment(owner, slices.size());
+                for (auto &slice : slices) { slice.owner = owner; }
+            }
+            return slices;
+        }
+
+        /// ### Releasing many vectors
+        /**
+         * Releases all of the vectors, and adjacent vectors that share the
+         * same control block release their references together.
+         */
+        static void release(std::span<shared_vector> const vectors) noexcept {
+            for (std::size_t index{}; index < vectors.size();) {
+                control_type *o = vectors[index].owner;
+                std::size_t count{};
+                for (; index < vectors.size() and vectors[index].owner == o;
+                     ++index, ++count) {
+                    vectors[index].owner = nullptr;
+                    vectors[index].buffer = {};
+                }
+                C::decrement(o, count);
+            }
+        }
 
         /// ### Conversions
         constexpr operator shared_view<T>() const { return {buffer, owner}; }
@@ -74,6 +160,25 @@ namespace felspar::memory {
 
         constexpr span_type memory() const noexcept { return buffer; }
         constexpr const_span_type cmemory() const noexcept { return buffer; }
+
+        /// ### Copy on write
+        /**
+         * Return the memory for writing to. If this vector holds the only
+         * reference to it then the memory is returned as it is, otherwise it
+         * is first copied into a new allocation from the resource that only
+         * this vector refers to.
+         */
+        span_type make_writable(
+                pmr::memory_resource *const resource =
+                        pmr::new_delete_resource()) {
+            if (owner and not owner->is_unique()) {
+                shared_vector copy{buffer.size(), resource};
+                std::copy(buffer.begin(), buffer.end(), copy.buffer.begin());
+                std::swap(buffer, copy.buffer);
+                std::swap(owner, copy.owner);
+            }
+            return buffer;
+        }
     };
 
     template<typename T>
@@ -82,8 +187,63 @@ namespace felspar::memory {
     }
 
 
+    /// ### Weak reference to a shared memory vector
+    /**
+     * As `weak_shared_buffer`, but for `shared_vector`. `lock` returns an
+     * empty vector once the memory is no longer in use.
+     */
+    template<typename T, typename C = atomic_counting>
+    class weak_shared_vector final {
+      public:
+        using shared_type = shared_vector<T, C>;
+        using span_type = typename shared_type::span_type;
+        using control_type = typename shared_type::control_type;
+
+        /// ### Constructors
+        weak_shared_vector() {}
+        weak_shared_vector(shared_type const &sv)
+        : buffer{sv.buffer}, owner{control_type::weak_increment(sv.owner)} {}
+        weak_shared_vector(weak_shared_vector const &wv)
+        : buffer{wv.buffer}, owner{control_type::weak_increment(wv.owner)} {}
+        weak_shared_vector &operator=(weak_shared_vector const &wv) {
+            buffer = wv.buffer;
+            control_type::weak_decrement(owner);
+            owner = control_type::weak_increment(wv.owner);
+            return *this;
+        }
+        ~weak_shared_vector() { control_type::weak_decrement(owner); }
+
+        /// ### Queries
+        bool expired() const noexcept {
+            return not owner or owner->use_count() == 0u;
+        }
+        constexpr std::size_t size() const noexcept { return buffer.size(); }
+
+        /// ### Access to the memory
+        shared_type lock() const noexcept {
+            shared_type sv;
+            if (auto *const c = control_type::lock(owner)) {
+                sv.buffer = buffer;
+                sv.owner = c;
+            }
+            return sv;
+        }
+
+      private:
+        span_type buffer;
+        control_type *owner = nullptr;
+    };
+
+
     /// ### Type aliases
     using shared_bytes = shared_vector<std::byte>;
+    template<typename T>
+    using local_shared_vector = shared_vector<T, local_counting>;
+    using local_shared_bytes = local_shared_vector<std::byte>;
+    template<typename T>
+    using biased_shared_vector = shared_vector<T, biased_counting>;
+    using biased_shared_bytes = biased_shared_vector<std::byte>;
+    using weak_shared_bytes = weak_shared_vector<std::byte>;
 
 
 }
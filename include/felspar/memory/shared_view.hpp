@@ -9,7 +9,7 @@
 namespace felspar::memory {
 
 
-    template<typename T>
+    template<typename T, typename C = atomic_counting>
     class shared_vector;
 
 
@@ -21,7 +21,7 @@ namespace felspar::memory {
      */
     template<typename T>
     class shared_view final {
-        template<typename Tt>
+        template<typename, typename>
         friend class shared_vector;
 
         std::span<std::byte> buffer;
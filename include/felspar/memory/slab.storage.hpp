@@ -4,7 +4,9 @@
 #include <felspar/memory/exceptions.hpp>
 #include <felspar/memory/sizes.hpp>
 
+#include <algorithm>
 #include <array>
+#include <cstdint>
 
 
 namespace felspar::memory {
@@ -33,6 +35,11 @@ namespace felspar::memory {
         [[nodiscard]] constexpr std::size_t free() const noexcept {
             return storage.size() - allocated_bytes;
         }
+        /// Return true if the memory belongs to this storage
+        [[nodiscard]] bool owns(void const *const p) const noexcept {
+            auto const *const b = reinterpret_cast<std::byte const *>(p);
+            return b >= storage.data() and b < storage.data() + storage.size();
+        }
 
         [[nodiscard]] constexpr std::byte *allocate(std::size_t bytes) {
             if (bytes > free()) {
@@ -45,7 +52,37 @@ namespace felspar::memory {
                 return base;
             }
         }
+        /// Allocate at the requested alignment, returning `nullptr` rather
+        /// than throwing if there isn't enough space left
+        [[nodiscard]] std::byte *try_allocate(
+                std::size_t const bytes,
+                std::size_t const alignment = alignment_size) noexcept {
+            auto const base = reinterpret_cast<std::uintptr_t>(storage.data());
+            std::size_t const start =
+                    aligned_offset(base + allocated_bytes, alignment) - base;
+            if (start > storage.size() or bytes > storage.size() - start) {
+                return nullptr;
+            } else {
+                allocated_bytes = std::min(
+                        aligned_offset(start + bytes, alignment_size),
+                        storage.size());
+                return storage.data() + start;
+            }
+        }
         constexpr void deallocate(void *, std::size_t) {}
+
+
+        /// ### Rewinding
+        /**
+         * Returns a marker for the current allocation position. Rewinding to
+         * the marker frees everything allocated after it was taken.
+         */
+        [[nodiscard]] constexpr std::size_t checkpoint() const noexcept {
+            return allocated_bytes;
+        }
+        constexpr void rewind(std::size_t const marker) noexcept {
+            allocated_bytes = marker;
+        }
     };
 
 
@@ -3,8 +3,11 @@
 
 #include <felspar/memory/small_vector.hpp>
 
+#include <algorithm>
 #include <array>
+#include <cstdint>
 #include <span>
+#include <utility>
 
 
 namespace felspar::memory {
@@ -14,6 +17,19 @@ namespace felspar::memory {
      * An allocator intended for use with small allocations where their
      * lifetimes don't extend beyond the allocator.
      *
+     * Allocations are taken from the top of a stack and freeing the most
+     * recent allocation just moves the top back down, so when memory is used
+     * in a last in first out manner both operations are a pointer bump.
+     * Memory that is freed out of order is kept in a list of free blocks,
+     * ordered by size and coalesced with any free neighbours, and re-used
+     * before the top of the stack is. The `A` parameter is the number of
+     * these free blocks that can be tracked, there is no limit on the number
+     * of live allocations.
+     *
+     * Freeing memory never fails. If all of the free blocks are already in
+     * use then the smallest fragment is left untracked, and its memory comes
+     * back once every allocation has been freed and the storage is empty.
+     *
      * This allocator is not thread safe.
      */
     template<
@@ -21,17 +37,21 @@ namespace felspar::memory {
             std::size_t A = 16u,
             std::size_t CA = alignof(std::max_align_t)>
     class stack_storage {
-        /// Storage memory for the
+        /// Storage memory for the allocations
         std::array<std::byte, S> storage alignas(CA);
         using allocation = std::span<std::byte>;
-        small_vector<allocation, A> allocations = {},
-                                    available = {allocation{
-                                            storage.data(), storage.size()}};
+        /// Offset of the top of the stack
+        std::size_t top = {};
+        /// Free blocks below the top of the stack, smallest first
+        small_vector<allocation, A> available = {};
+        /// The number of allocations that haven't been freed
+        std::size_t live = {};
 
 
       public:
         /// ### The size of the usable storage in bytes
         static std::size_t constexpr storage_bytes{S};
+        /// The number of out of order free blocks that can be tracked
         static std::size_t constexpr allocation_count{A};
         static std::size_t constexpr alignment_size{CA};
 
@@ -46,81 +66,166 @@ namespace felspar::memory {
 
         /// ### Return the amount of free memory remaining in the storage
         [[nodiscard]] constexpr auto free() const noexcept {
-            std::size_t f{};
+            std::size_t f{storage.size() - top};
             for (auto a : available) { f += a.size(); }
             return f;
         }
 
 
+        /// ### Return true if the memory belongs to this storage
+        [[nodiscard]] bool owns(void const *const p) const noexcept {
+            auto const *const b = reinterpret_cast<std::byte const *>(p);
+            return b >= storage.data() and b < storage.data() + storage.size();
+        }
+
+
         /// ### Allocate a number of bytes
-        [[nodiscard]] constexpr std::byte *allocate(
+        [[nodiscard]] std::byte *allocate(
                 std::size_t const abytes,
                 std::source_location const &loc =
                         std::source_location::current()) {
-            auto const bytes = block_size(abytes, alignment_size);
-            /// Search through available blocks for the smallest that satisfies
-            /// the allocation
-            std::size_t best_alloc = -1;
-            auto best_pos = available.end();
-            for (auto pos = available.begin(); pos != available.end(); ++pos) {
-                if (pos->size() >= bytes and pos->size() < best_alloc) {
-                    best_alloc = pos->size();
-                    best_pos = pos;
-                }
-            }
-            if (best_pos == available.end()) /*[[unlikely]]*/ {
-                if (bytes > free()) {
-                    detail::throw_bad_alloc(
-                            "Out of free memory -- memory exhausted", loc);
-                } else {
-                    detail::throw_bad_alloc(
-                            "Out of free memory -- memory fragmentation", loc);
-                }
-            }
-
-            /// Do the bookkeeping needed to record the allocation and remove
-            /// from the available memory
-            if (allocations.size() == allocations.capacity()) /*[[unlikely]]*/ {
+            if (auto *const p = try_allocate(abytes)) [[likely]] {
+                return p;
+            } else if (block_size(abytes, alignment_size) > free()) {
                 detail::throw_bad_alloc(
-                        "Out of allocation bookkeeping slots", loc);
+                        "Out of free memory -- memory exhausted", loc);
             } else {
-                auto const alloc = best_pos->first(bytes);
-                if (auto const remaining = best_pos->subspan(bytes);
-                    remaining.size() >= alignment_size) {
-                    *best_pos = remaining;
-                } else {
-                    available.erase(best_pos);
+                detail::throw_bad_alloc(
+                        "Out of free memory -- memory fragmentation", loc);
+            }
+        }
+        /// ### Allocate at an alignment
+        /**
+         * Returns `nullptr` rather than throwing if the allocation can't be
+         * made. Any space skipped over to reach the alignment is left
+         * available for later allocations.
+         */
+        [[nodiscard]] std::byte *try_allocate(
+                std::size_t const abytes,
+                std::size_t const alignment = alignment_size) noexcept {
+            auto const bytes = block_size(abytes, alignment_size);
+            auto const align = std::max(alignment, alignment_size);
+            if (not available.empty()) {
+                /// Best fit from the free blocks
+                for (auto pos = std::lower_bound(
+                             available.begin(), available.end(), bytes,
+                             [](allocation const a, std::size_t const b) {
+                                 return a.size() < b;
+                             });
+                     pos != available.end(); ++pos) {
+                    auto const padding = padding_for(pos->data(), align);
+                    if (pos->size() >= padding + bytes) {
+                        auto *const p = take(pos, padding, bytes);
+                        if (p) { ++live; }
+                        return p;
+                    }
                 }
-                allocations.push_back(alloc);
-                return alloc.data();
             }
+            /// Then from the top of the stack
+            auto *const base = storage.data() + top;
+            auto const padding = padding_for(base, align);
+            if (padding + bytes > storage.size() - top) {
+                return nullptr;
+            } else if (padding) {
+                if (not available.has_room()) { return nullptr; }
+                insert({base, padding});
+            }
+            top += padding + bytes;
+            ++live;
+            return base + padding;
         }
-        constexpr void deallocate(
+
+
+        /// ### Free an allocation
+        void deallocate(
                 void *location,
-                std::size_t,
+                std::size_t const abytes,
                 std::source_location const &loc =
                         std::source_location::current()) {
-            for (auto pos = allocations.begin(); pos != allocations.end();
-                 ++pos) {
-                if (location == pos->data()) {
-                    for (auto &free : available) {
-                        if (pos->data() + pos->size() == free.data()) {
-                            free = {pos->data(), pos->size() + free.size()};
-                            allocations.erase(pos);
-                            return;
-                        } else if (free.data() + free.size() == pos->data()) {
-                            free = {free.data(), free.size() + pos->size()};
-                            allocations.erase(pos);
-                            return;
-                        }
+            auto *const p = reinterpret_cast<std::byte *>(location);
+            auto const bytes = block_size(abytes, alignment_size);
+            if (not owns(p) or live == 0u
+                or static_cast<std::size_t>(p - storage.data()) + bytes > top) {
+                detail::throw_logic_error(
+                        "Bookkeeping entry for allocation not found", loc);
+            } else if (--live == 0u) {
+                /// Everything has been freed, including any fragments that
+                /// couldn't be tracked
+                top = 0u;
+                available.clear();
+            } else if (p + bytes == storage.data() + top) {
+                top = p - storage.data();
+                /// A free block that now ends at the top is absorbed into the
+                /// top of the stack
+                for (auto pos = available.begin(); pos != available.end();
+                     ++pos) {
+                    if (pos->data() + pos->size() == storage.data() + top) {
+                        top = pos->data() - storage.data();
+                        available.erase(pos);
+                        return;
+                    }
+                }
+            } else {
+                allocation freed{p, bytes};
+                for (auto pos = available.begin(); pos != available.end();) {
+                    if (pos->data() + pos->size() == freed.data()) {
+                        freed = {pos->data(), pos->size() + freed.size()};
+                        available.erase(pos);
+                    } else if (freed.data() + freed.size() == pos->data()) {
+                        freed = {freed.data(), freed.size() + pos->size()};
+                        available.erase(pos);
+                    } else {
+                        ++pos;
                     }
-                    available.emplace_back(pos->data(), pos->size());
-                    allocations.erase(pos);
-                    return;
                 }
+                if (not available.has_room()) {
+                    /// Keep the larger of this block and the smallest one
+                    /// being tracked, the other is left untracked
+                    if (available.empty()
+                        or available.front().size() >= freed.size()) {
+                        return;
+                    }
+                    available.erase(available.begin());
+                }
+                insert(freed);
+            }
+        }
+
+
+      private:
+        static std::size_t padding_for(
+                std::byte const *const p, std::size_t const alignment) noexcept {
+            auto const base = reinterpret_cast<std::uintptr_t>(p);
+            return aligned_offset(base, alignment) - base;
+        }
+        /// Add a free block keeping them ordered by size
+        void insert(allocation const block) {
+            available.push_back(block);
+            std::rotate(
+                    std::upper_bound(
+                            available.begin(), available.end() - 1,
+                            block.size(),
+                            [](std::size_t const b, allocation const a) {
+                                return b < a.size();
+                            }),
+                    available.end() - 1, available.end());
+        }
+        /// Allocate from a free block, returning `nullptr` if there aren't
+        /// enough bookkeeping slots to record the pieces left over
+        std::byte *take(
+                allocation *const pos,
+                std::size_t const padding,
+                std::size_t const bytes) noexcept {
+            auto const block = *pos;
+            auto const remaining = block.subspan(padding + bytes);
+            if (padding and not remaining.empty() and not available.has_room())
+            /*[[unlikely]]*/ {
+                return nullptr;
             }
-            detail::throw_logic_error(
-                    "Bookkeeping entry for allocation not found", loc);
+            available.erase(pos);
+            if (padding) { insert(block.first(padding)); }
+            if (not remaining.empty()) { insert(remaining); }
+            return block.data() + padding;
         }
     };
 
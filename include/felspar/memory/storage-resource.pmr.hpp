@@ -0,0 +1,72 @@
+#pragma once
+
+
+#include <felspar/memory/exceptions.hpp>
+#include <felspar/memory/pmr.hpp>
+
+
+namespace felspar::memory {
+
+
+    /// ## Memory resource over a storage
+    /**
+     * Adapts one of the storage types (`slab_storage` or `stack_storage`) so
+     * that it can be used as a `pmr::memory_resource`, which means it can be
+     * used to back the `std::pmr` containers. The requested alignment is
+     * honoured for every allocation.
+     *
+     * When the storage runs out of space allocations are passed on to the
+     * upstream allocator, or if there is no upstream, `std::bad_alloc` is
+     * thrown.
+     *
+     * This resource is not thread safe.
+     */
+    template<typename Storage>
+    class storage_resource : public pmr::memory_resource {
+        void *do_allocate(std::size_t bytes, std::size_t alignment) override {
+            if (auto *const p = store.try_allocate(bytes, alignment)) {
+                return p;
+            } else if (upstream) {
+                return upstream->allocate(bytes, alignment);
+            } else {
+                detail::throw_bad_alloc(
+                        "Storage exhausted and there is no upstream allocator",
+                        std::source_location::current());
+            }
+        }
+        void do_deallocate(
+                void *p, std::size_t bytes, std::size_t alignment) override {
+            if (store.owns(p)) {
+                store.deallocate(p, bytes);
+            } else {
+                upstream->deallocate(p, bytes, alignment);
+            }
+        }
+        bool do_is_equal(memory_resource const &other) const noexcept override {
+            return this == &other;
+        }
+
+        Storage store;
+        pmr::memory_resource *upstream;
+
+
+      public:
+        using storage_type = Storage;
+
+
+        /// ### Construction
+        explicit storage_resource(
+                pmr::memory_resource *const upstream = nullptr) noexcept
+        : upstream{upstream} {}
+
+        storage_resource(storage_resource const &) = delete;
+        storage_resource &operator=(storage_resource const &) = delete;
+
+
+        /// ### Access to the underlying storage
+        storage_type &storage() noexcept { return store; }
+        storage_type const &storage() const noexcept { return store; }
+    };
+
+
+}
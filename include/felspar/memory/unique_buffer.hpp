@@ -0,0 +1,169 @@
+#pragma once
+
+
+#include <felspar/memory/shared_buffer.hpp>
+#include <felspar/memory/shared_vector.hpp>
+
+
+namespace felspar::memory {
+
+
+    /// ## A uniquely owned memory buffer
+    /**
+     * Owns an array of items without any reference counting. Space for the
+     * control block is reserved in front of the items, so when the buffer is
+     * ready to be published `share` turns it into a `shared_buffer` or a
+     * `shared_vector` without copying the items or allocating any more memory.
+     *
+     * The buffer can be moved, but not copied.
+     */
+    template<typename T>
+    class unique_buffer final {
+        using block_type = array_control<T>;
+
+
+      public:
+        using value_type = T;
+        using buffer_type = std::span<T>;
+        using const_buffer_type = std::span<T const>;
+
+
+        /// ### Construction, destruction and assignment
+        unique_buffer() {}
+        unique_buffer(unique_buffer &&ub) noexcept
+        : buffer{std::exchange(ub.buffer, {})},
+          resource{std::exchange(ub.resource, nullptr)} {}
+        unique_buffer &operator=(unique_buffer &&ub) noexcept {
+            reset();
+            buffer = std::exchange(ub.buffer, {});
+            resource = std::exchange(ub.resource, nullptr);
+            return *this;
+        }
+        ~unique_buffer() { reset(); }
+
+        unique_buffer(unique_buffer const &) = delete;
+        unique_buffer &operator=(unique_buffer const &) = delete;
+
+
+        /// ### Allocation
+        /**
+         * The items are constructed as copies of `v` in memory taken from the
+         * resource, after the space reserved for the control block.
+         */
+        template<typename V = value_type>
+        static unique_buffer allocate(
+                std::size_t const count,
+                V const &v = {},
+                pmr::memory_resource *const resource =
+                        pmr::new_delete_resource()) {
+            auto const bytes = block_type::allocation_bytes(count);
+            auto *const memory = reinterpret_cast<std::byte *>(
+                    resource->allocate(bytes, block_type::block_alignment()));
+            auto *const items = std::launder(reinterpret_cast<value_type *>(
+                    memory + block_type::data_offset()));
+            try {
+                std::uninitialized_fill_n(items, count, v);
+            } catch (...) {
+                resource->deallocate(
+                        memory, bytes, block_type::block_alignment());
+                throw;
+            }
+            unique_buffer ub;
+            ub.buffer = {items, count};
+            ub.resource = resource;
+            return ub;
+        }
+
+
+        /// ### Sharing the buffer
+        /**
+         * Creates the control block in the reserved space and hands the items
+         * over to it. The unique buffer is left empty. `S` may be any
+         * `shared_buffer<T, C>`, and for bytes any `shared_vector`.
+         */
+        template<typename S = shared_buffer<T>>
+        [[nodiscard]] S share() && {
+            S shared;
+            if (resource) {
+                auto *const block = block_type::adopt(
+                        header(), buffer.size(), buffer.size(),
+                        std::exchange(resource, nullptr));
+                shared.buffer = std::exchange(buffer, {});
+                shared.owner = S::counting_type::created(block);
+            }
+            return shared;
+        }
+
+
+        /// ### Information about the buffer
+        bool empty() const noexcept { return buffer.empty(); }
+        auto size() const noexcept { return buffer.size(); }
+
+
+        /// ### Access to the buffer
+        buffer_type memory() noexcept { return buffer; }
+        const_buffer_type cmemory() const noexcept { return buffer; }
+
+        value_type &operator[](std::size_t const i) { return buffer[i]; }
+        value_type const &operator[](std::size_t const i) const {
+            return buffer[i];
+        }
+
+        /// #### Access an element with a bounds check
+        value_type &
+                at(std::size_t const i,
+                   std::source_location const &loc =
+                           std::source_location::current()) {
+            if (i >= buffer.size()) {
+                detail::throw_logic_error("Buffer overrun", loc);
+            } else {
+                return buffer[i];
+            }
+        }
+        value_type const &
+                at(std::size_t const i,
+                   std::source_location const &loc =
+                           std::source_location::current()) const {
+            if (i >= buffer.size()) {
+                detail::throw_logic_error("Buffer overrun", loc);
+            } else {
+                return buffer[i];
+            }
+        }
+        auto begin() { return buffer.begin(); }
+        auto end() { return buffer.end(); }
+        auto begin() const { return buffer.begin(); }
+        auto end() const { return buffer.end(); }
+
+        value_type *data() noexcept { return buffer.data(); }
+        value_type const *data() const noexcept { return buffer.data(); }
+
+
+        /// ### Implicit conversions
+        operator std::span<value_type>() noexcept { return buffer; }
+        operator std::span<value_type const>() const noexcept { return buffer; }
+
+
+      private:
+        buffer_type buffer;
+        pmr::memory_resource *resource = nullptr;
+
+        void *header() noexcept {
+            return reinterpret_cast<std::byte *>(buffer.data())
+                    - block_type::data_offset();
+        }
+        void reset() noexcept {
+            if (resource) {
+                std::destroy(buffer.begin(), buffer.end());
+                std::exchange(resource, nullptr)
+                        ->deallocate(
+                                header(),
+                                block_type::allocation_bytes(buffer.size()),
+                                block_type::block_alignment());
+                buffer = {};
+            }
+        }
+    };
+
+
+}
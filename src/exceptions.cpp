@@ -29,3 +29,9 @@ void felspar::memory::detail::throw_overaligned_memory(
                     + std::to_string(alignment) + " bytes",
             loc};
 }
+
+
+void felspar::memory::detail::throw_system_error(
+        int const error, char const *m, std::source_location const &loc) {
+    throw system_error{error, m, loc};
+}
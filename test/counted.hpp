@@ -0,0 +1,20 @@
+#pragma once
+
+
+#include <atomic>
+#include <cstddef>
+
+
+namespace felspar::memory::test {
+
+
+    /// A type that counts how many instances of it are alive
+    struct counted {
+        static inline std::atomic<std::size_t> live = {};
+        counted() { ++live; }
+        counted(counted const &) { ++live; }
+        ~counted() { --live; }
+    };
+
+
+}
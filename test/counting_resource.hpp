@@ -0,0 +1,33 @@
+#pragma once
+
+
+#include <felspar/memory/pmr.hpp>
+
+#include <atomic>
+
+
+namespace felspar::memory::test {
+
+
+    /// A memory resource that counts the calls made to it
+    struct counting_resource : public felspar::pmr::memory_resource {
+        std::atomic<std::size_t> allocations = {}, deallocations = {};
+
+        void *do_allocate(std::size_t bytes, std::size_t alignment) override {
+            ++allocations;
+            return felspar::pmr::new_delete_resource()->allocate(
+                    bytes, alignment);
+        }
+        void do_deallocate(
+                void *p, std::size_t bytes, std::size_t alignment) override {
+            ++deallocations;
+            felspar::pmr::new_delete_resource()->deallocate(
+                    p, bytes, alignment);
+        }
+        bool do_is_equal(memory_resource const &other) const noexcept override {
+            return this == &other;
+        }
+    };
+
+
+}
@@ -0,0 +1 @@
+#include <felspar/memory/arena.pmr.hpp>
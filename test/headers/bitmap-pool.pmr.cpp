@@ -0,0 +1 @@
+#include <felspar/memory/bitmap-pool.pmr.hpp>
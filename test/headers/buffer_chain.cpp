@@ -0,0 +1 @@
+#include <felspar/memory/buffer_chain.hpp>
@@ -0,0 +1 @@
+#include <felspar/memory/concurrent-fixed-pool.pmr.hpp>
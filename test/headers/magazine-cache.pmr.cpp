@@ -0,0 +1 @@
+#include <felspar/memory/magazine-cache.pmr.hpp>
@@ -0,0 +1 @@
+#include <felspar/memory/mapped_file.hpp>
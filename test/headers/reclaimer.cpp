@@ -0,0 +1 @@
+#include <felspar/memory/reclaimer.hpp>
@@ -0,0 +1 @@
+#include <felspar/memory/segregated-pool.pmr.hpp>
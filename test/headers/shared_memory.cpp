@@ -0,0 +1 @@
+#include <felspar/memory/shared_memory.hpp>
@@ -0,0 +1 @@
+#include <felspar/memory/storage-resource.pmr.hpp>
@@ -0,0 +1 @@
+#include <felspar/memory/unique_buffer.hpp>
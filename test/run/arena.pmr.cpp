@@ -0,0 +1,77 @@
+#include <felspar/memory/arena.pmr.hpp>
+#include <felspar/test.hpp>
+
+#include "../counting_resource.hpp"
+
+
+namespace {
+
+
+    auto const suite = felspar::testsuite("arena.pmr");
+
+
+    using felspar::memory::test::counting_resource;
+
+
+    auto const s = suite.test("slab", [](auto check) {
+        counting_resource upstream;
+        felspar::memory::arena<256> a{&upstream};
+
+        auto *a1 = reinterpret_cast<std::byte *>(a.allocate(10, 1));
+        auto *a2 = reinterpret_cast<std::byte *>(a.allocate(8, 8));
+        check(a2) == a1 + 16;
+        auto *a3 = reinterpret_cast<std::byte *>(a.allocate(1, 64));
+        check(reinterpret_cast<std::uintptr_t>(a3) % 64u) == 0u;
+        check(upstream.allocations) == 0u;
+    });
+
+
+    auto const c = suite.test("chained", [](auto check) {
+        counting_resource upstream;
+        {
+            felspar::memory::arena<256> a{&upstream};
+            auto const start = a.checkpoint();
+
+            for (std::size_t index{}; index < 100; ++index) {
+                [[maybe_unused]] auto *p = a.allocate(16);
+            }
+            auto const chunks = upstream.allocations.load();
+            check(chunks) > 0u;
+
+            a.rewind(start);
+            for (std::size_t index{}; index < 100; ++index) {
+                [[maybe_unused]] auto *p = a.allocate(16);
+            }
+            check(upstream.allocations) == chunks;
+
+            auto *big = a.allocate(10'000);
+            check(big) != nullptr;
+            check(upstream.allocations) == chunks + 1u;
+        }
+        check(upstream.deallocations) == upstream.allocations;
+    });
+
+
+    auto const r = suite.test("rewind", [](auto check) {
+        felspar::memory::arena<64> a;
+
+        void *a1 = a.allocate(32);
+        auto const m1 = a.checkpoint();
+        void *a2 = a.allocate(32);
+        a.rewind(m1);
+        check(a.allocate(32)) == a2;
+
+        void *a3 = a.allocate(128);
+        auto const m2 = a.checkpoint();
+        void *a4 = a.allocate(16);
+        a.rewind(m2);
+        check(a.allocate(16)) == a4;
+
+        a.rewind(m1);
+        check(a.allocate(32)) == a2;
+        check(a.allocate(128)) == a3;
+        check(a1) != a3;
+    });
+
+
+}
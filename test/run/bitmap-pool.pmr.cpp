@@ -0,0 +1,82 @@
+#include <felspar/memory/bitmap-pool.pmr.hpp>
+#include <felspar/test.hpp>
+
+#include <set>
+
+
+namespace {
+
+
+    auto const suite = felspar::testsuite("bitmap-pool.pmr");
+
+
+    auto const s = suite.test("small", [](auto check) {
+        felspar::memory::bitmap_pool bp{
+                100, 10, felspar::pmr::new_delete_resource()};
+        check(bp.block_size()) == 112u;
+        check(bp.capacity()) == 10u;
+        check(bp.free()) == 10u;
+
+        void *a1 = bp.allocate(100);
+        void *a2 = bp.allocate(50);
+        check(a1) != a2;
+        check(bp.owns(a1)) == true;
+        check(bp.owns(a2)) == true;
+        check(reinterpret_cast<std::byte *>(a2))
+                == reinterpret_cast<std::byte *>(a1) + 112;
+        check(bp.free()) == 8u;
+
+        bp.deallocate(a1, 100);
+        check(bp.free()) == 9u;
+        void *a3 = bp.allocate(10);
+        check(a3) == a1;
+
+        bp.deallocate(a2, 50);
+        bp.deallocate(a3, 10);
+        check(bp.free()) == 10u;
+    });
+
+
+    auto const b = suite.test("big", [](auto check) {
+        felspar::memory::bitmap_pool bp{
+                64, 4, felspar::pmr::new_delete_resource()};
+
+        void *a1 = bp.allocate(1000);
+        check(bp.owns(a1)) == false;
+        check(bp.free()) == 4u;
+        bp.deallocate(a1, 1000);
+    });
+
+
+    auto const m = suite.test("many", [](auto check) {
+        constexpr std::size_t count = 10'000;
+        felspar::memory::bitmap_pool bp{
+                16, count, felspar::pmr::new_delete_resource()};
+
+        std::set<void *> seen;
+        std::vector<void *> blocks;
+        for (std::size_t index{}; index < count; ++index) {
+            blocks.push_back(bp.allocate(16));
+            check(bp.owns(blocks.back())) == true;
+            seen.insert(blocks.back());
+        }
+        check(seen.size()) == count;
+        check(bp.free()) == 0u;
+
+        /// Once exhausted, allocations come from upstream
+        void *over = bp.allocate(16);
+        check(bp.owns(over)) == false;
+        bp.deallocate(over, 16);
+
+        /// Freed blocks are re-used, lowest address first
+        bp.deallocate(blocks[9'000], 16);
+        bp.deallocate(blocks[70], 16);
+        check(bp.allocate(16)) == blocks[70];
+        check(bp.allocate(16)) == blocks[9'000];
+
+        for (auto p : blocks) { bp.deallocate(p, 16); }
+        check(bp.free()) == count;
+    });
+
+
+}
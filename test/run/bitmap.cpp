@@ -18,6 +18,8 @@ namespace {
         check(bm::nextbit(std::uint8_t{0b1111'1110})) == 0u;
         check(bm::nextbit(std::uint8_t{0b1111'0111})) == 3u;
         check(bm::nextbit(std::uint8_t{0b1111'1111})) == 8u;
+        check(bm::nextbit(~std::uint64_t{})) == 64u;
+        check(bm::nextbit(std::uint64_t{0x7fff'ffff'ffff'ffff})) == 63u;
     });
 
 
@@ -41,4 +43,19 @@ namespace {
     });
 
 
+    auto const wide = suite.test("allocate/64 bit", [](auto check) {
+        std::array<std::byte, 64> memory{};
+        std::uint64_t blocks{0x7fff'ffff'ffff'ffff};
+
+        namespace bm = felspar::memory::bitmap;
+
+        check(bm::allocate(blocks, memory.data(), 1u)) == memory.data() + 63;
+        check(blocks) == ~std::uint64_t{};
+        check(bm::allocate(blocks, memory.data(), 1u)) == nullptr;
+
+        bm::deallocate(memory.data() + 63, blocks, memory.data(), 1u);
+        check(blocks) == 0x7fff'ffff'ffff'ffffu;
+    });
+
+
 }
@@ -0,0 +1,140 @@
+#include <felspar/memory/buffer_chain.hpp>
+#include <felspar/test.hpp>
+
+#include <felspar/exceptions.hpp>
+
+#include <array>
+#include <string_view>
+
+#if __has_include(<unistd.h>)
+#include <unistd.h>
+#endif
+
+
+namespace {
+
+
+    auto const suite = felspar::testsuite("buffer_chain");
+
+
+    auto bytes_of(std::size_t const count, std::byte const value) {
+        return felspar::memory::shared_buffer<std::byte>::allocate(
+                count, value);
+    }
+
+
+    template<typename B>
+    concept appendable = requires(felspar::memory::buffer_chain &c, B &&b) {
+        c.append(std::forward<B>(b));
+        c.prepend(std::forward<B>(b));
+    };
+    static_assert(appendable<felspar::memory::shared_buffer<std::byte>>);
+    static_assert(appendable<felspar::memory::shared_buffer<std::byte> &>);
+    static_assert(appendable<felspar::memory::shared_bytes const &>);
+    static_assert(
+            not appendable<felspar::memory::local_shared_buffer<std::byte>>);
+    static_assert(
+            not appendable<felspar::memory::local_shared_buffer<std::byte> &>);
+    static_assert(not appendable<felspar::memory::local_shared_bytes const &>);
+
+
+    auto const local = suite.test("local counting", [](auto check) {
+        auto body =
+                felspar::memory::local_shared_buffer<std::byte>::allocate(4);
+        felspar::memory::buffer_chain chain;
+        chain.append(felspar::memory::shared_buffer<std::byte>{body});
+        check(chain.size()) == 4u;
+        check(body.control_block()->use_count()) == 2u;
+        chain.clear();
+        check(body.control_block()->use_count()) == 1u;
+    });
+
+
+    auto const build = suite.test("build", [](auto check) {
+        felspar::memory::buffer_chain chain;
+        check(chain.empty()) == true;
+        check(chain.iovecs().size()) == 0u;
+
+        auto body = bytes_of(10, std::byte{'b'});
+        chain.append(body);
+        check(body.control_block()->use_count()) == 2u;
+        chain.prepend(bytes_of(4, std::byte{'h'}));
+        felspar::memory::shared_bytes trailer{3};
+        chain.append(trailer);
+        chain.append(felspar::memory::shared_buffer<std::byte>{});
+        check(chain.size()) == 17u;
+        check(chain.segment_count()) == 3u;
+
+        auto const iov = chain.iovecs();
+        check(iov.size()) == 3u;
+        check(iov[0].iov_len) == 4u;
+        check(iov[1].iov_base) == static_cast<void *>(body.memory().data());
+        check(iov[2].iov_base) == static_cast<void *>(trailer.data());
+
+        for (std::size_t count{}; count < 20u; ++count) {
+            chain.prepend(bytes_of(1, std::byte{'p'}));
+        }
+        check(chain.segment_count()) == 23u;
+        check(chain.size()) == 37u;
+        check(*static_cast<std::byte *>(chain.iovecs()[20].iov_base))
+                == std::byte{'h'};
+
+        auto copy = chain;
+        check(body.control_block()->use_count()) == 3u;
+        chain.clear();
+        check(body.control_block()->use_count()) == 2u;
+        chain = std::move(copy);
+        check(body.control_block()->use_count()) == 2u;
+        check(chain.size()) == 37u;
+    });
+
+
+    auto const consume = suite.test("consume", [](auto check) {
+        felspar::memory::buffer_chain chain;
+        auto first = bytes_of(4, std::byte{1});
+        auto const *const control = first.control_block();
+        chain.append(std::move(first));
+        check(first.empty()) == true;
+        check(control->use_count()) == 1u;
+        auto second = bytes_of(6, std::byte{2});
+        chain.append(second);
+
+        chain.consume(3);
+        check(chain.size()) == 7u;
+        check(chain.iovecs()[0].iov_len) == 1u;
+        chain.consume(3);
+        check(chain.segment_count()) == 1u;
+        check(chain.iovecs()[0].iov_len) == 4u;
+        check(second.control_block()->use_count()) == 2u;
+        check([&]() { chain.consume(5); })
+                .throws(felspar::stdexcept::logic_error{"Buffer overrun"});
+        chain.consume(4);
+        check(chain.empty()) == true;
+        check(chain.segment_count()) == 0u;
+        check(second.control_block()->use_count()) == 1u;
+    });
+
+
+#if __has_include(<unistd.h>)
+    auto const wv = suite.test("writev", [](auto check) {
+        felspar::memory::buffer_chain chain;
+        chain.append(bytes_of(3, std::byte{'b'}));
+        chain.prepend(bytes_of(2, std::byte{'a'}));
+        chain.append(bytes_of(1, std::byte{'c'}));
+
+        std::array<int, 2> fds{};
+        check(::pipe(fds.data())) == 0;
+        auto const iov = chain.iovecs();
+        check(::writev(fds[1], iov.data(), static_cast<int>(iov.size())))
+                == 6;
+        chain.consume(6);
+        std::array<char, 8> got{};
+        check(::read(fds[0], got.data(), got.size())) == 6;
+        check(std::string_view{got.data(), 6}) == "aabbbc";
+        ::close(fds[0]);
+        ::close(fds[1]);
+    });
+#endif
+
+
+}
@@ -0,0 +1,139 @@
+#include <felspar/memory/buffer_pool.hpp>
+#include <felspar/test.hpp>
+
+#include "../counting_resource.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <thread>
+
+
+namespace {
+
+
+    auto const suite = felspar::testsuite("buffer_pool");
+
+
+    using felspar::memory::test::counting_resource;
+
+
+    auto const r = suite.test("recycle", [](auto check) {
+        counting_resource upstream;
+        {
+            felspar::memory::buffer_pool pool{
+                    4u << 10, 64u << 10, 64u, &upstream};
+            check(pool.bucket_size(1000)) == 4096u;
+            check(pool.bucket_size(4097)) == 8192u;
+
+            std::byte const *first = nullptr;
+            {
+                auto v = pool.allocate_vector(1000);
+                check(v.size()) == 1000u;
+                first = v.data();
+                check(upstream.allocations) == 1u;
+                check(pool.cached()) == 0u;
+            }
+            check(pool.cached()) == 1u;
+            check(upstream.deallocations) == 0u;
+            {
+                auto b = pool.allocate_buffer(4000);
+                check(b.size()) == 4000u;
+                check(b.data()) == first;
+                check(upstream.allocations) == 1u;
+                auto const part = b.first(10);
+                b = {};
+                check(pool.cached()) == 0u;
+            }
+            check(pool.cached()) == 1u;
+        }
+        check(upstream.deallocations) == 1u;
+    });
+
+
+    auto const z = suite.test("contents", [](auto check) {
+        felspar::memory::buffer_pool pool{4u << 10, 64u << 10};
+        {
+            auto v = pool.allocate_vector(100);
+            std::fill_n(v.data(), v.size(), std::byte{0xab});
+        }
+        {
+            /// Recycled memory still holds what the last user wrote
+            auto const v = pool.allocate_vector(100);
+            check(v.data()[0]) == std::byte{0xab};
+            check(v.data()[99]) == std::byte{0xab};
+        }
+        {
+            auto const v = pool.allocate_vector(
+                    100, felspar::memory::buffer_pool::contents::zeroed);
+            check(std::count(v.data(), v.data() + v.size(), std::byte{}))
+                    == 100;
+        }
+        {
+            auto b = pool.allocate_buffer(100);
+            std::fill_n(b.memory().data(), 100, std::byte{0xcd});
+        }
+        {
+            auto const b = pool.allocate_buffer(
+                    100, felspar::memory::buffer_pool::contents::zeroed);
+            check(std::count(b.begin(), b.end(), std::byte{})) == 100;
+        }
+    });
+
+
+    auto const c = suite.test("cap", [](auto check) {
+        counting_resource upstream;
+        felspar::memory::buffer_pool pool{4u << 10, 64u << 10, 2u, &upstream};
+        {
+            auto const b1 = pool.allocate_vector(5000);
+            auto const b2 = pool.allocate_vector(5000);
+            auto const b3 = pool.allocate_vector(5000);
+            check(upstream.allocations) == 3u;
+        }
+        check(pool.cached()) == 2u;
+        check(upstream.deallocations) == 1u;
+
+        pool.preallocate(100, 5);
+        check(pool.cached()) == 4u;
+        check(upstream.allocations) == 5u;
+    });
+
+
+    auto const l = suite.test("large", [](auto check) {
+        counting_resource upstream;
+        felspar::memory::buffer_pool pool{4u << 10, 64u << 10, 2u, &upstream};
+        {
+            auto const v = pool.allocate_vector(100u << 10);
+            check(v.size()) == 100u << 10;
+            auto const b = pool.allocate_buffer(100u << 10);
+            check(b.size()) == 100u << 10;
+            check(upstream.allocations) == 2u;
+        }
+        check(upstream.deallocations) == 2u;
+        check(pool.cached()) == 0u;
+    });
+
+
+    auto const t = suite.test("threads", [](auto check) {
+        counting_resource upstream;
+        {
+            felspar::memory::buffer_pool pool{
+                    4u << 10, 64u << 10, 8u, &upstream};
+            std::vector<std::thread> threads;
+            for (std::size_t index{}; index < 4u; ++index) {
+                threads.emplace_back([&pool, index]() {
+                    for (std::size_t count{}; count < 1000u; ++count) {
+                        auto b = pool.allocate_buffer((index + 1u) << 12);
+                        b[0] = std::byte{1};
+                    }
+                });
+            }
+            for (auto &t : threads) { t.join(); }
+            check(pool.cached() <= 4u * 8u) == true;
+            check(upstream.allocations - upstream.deallocations)
+                    == pool.cached();
+        }
+        check(upstream.allocations) == upstream.deallocations;
+    });
+
+
+}
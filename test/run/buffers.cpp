@@ -1,6 +1,13 @@
 #include <felspar/memory/accumulation_buffer.hpp>
+#include <felspar/memory/shared_vector.hpp>
 #include <felspar/test.hpp>
 
+#include "../counting_resource.hpp"
+
+#include <felspar/exceptions.hpp>
+
+#include <array>
+
 
 namespace {
 
@@ -55,4 +62,230 @@ namespace {
     });
 
 
+    auto const pc = suite.test("prepare/commit", [](auto check) {
+        felspar::memory::accumulation_buffer<std::byte> bytes{64};
+        auto tail = bytes.prepare(16);
+        check(tail.size()) == 16u;
+        check(bytes.size()) == 0u;
+        tail[0] = std::byte{1};
+        tail[1] = std::byte{2};
+        bytes.commit(2);
+        check(bytes.size()) == 2u;
+        check(bytes[1]) == std::byte{2};
+
+        tail = bytes.prepare(100);
+        check(tail.size()) == 100u;
+        check(bytes[0]) == std::byte{1};
+        tail[99] = std::byte{99};
+        bytes.commit(100);
+        check(bytes.size()) == 102u;
+        check(bytes[101]) == std::byte{99};
+        check([&]() { bytes.commit(1u << 20); })
+                .throws(felspar::stdexcept::logic_error{
+                        "Committing more memory than was prepared"});
+
+        auto const first = bytes.first(2);
+        auto copy = bytes;
+        copy.prepare(1)[0] = std::byte{3};
+        copy.commit(1);
+        bytes.prepare(1)[0] = std::byte{4};
+        bytes.commit(1);
+        check(copy[100]) == std::byte{3};
+        check(bytes[100]) == std::byte{4};
+    });
+
+
+#if __has_include(<sys/uio.h>) and __has_include(<unistd.h>)
+    auto const rf = suite.test("read_from", [](auto check) {
+        std::array<int, 2> fds{};
+        check(::pipe(fds.data())) == 0;
+        std::array<char, 300> message{};
+        for (std::size_t index{}; index < message.size(); ++index) {
+            message[index] = static_cast<char>(index);
+        }
+        check(::write(fds[1], message.data(), 100)) == 100;
+
+        felspar::memory::accumulation_buffer<std::byte> bytes{32};
+        check(bytes.read_from(fds[0], 40)) == 40;
+        check(bytes.size()) == 40u;
+        check(bytes[39]) == std::byte{39};
+
+        std::array<std::byte, 1024> overflow;
+        check(bytes.read_from(fds[0], overflow)) == 60;
+        check(bytes.size()) == 100u;
+        check(bytes[99]) == std::byte{99};
+
+        check(::write(fds[1], message.data() + 100, 200)) == 200;
+        ::close(fds[1]);
+        check(bytes.read_from(fds[0], overflow)) == 200;
+        check(bytes.size()) == 300u;
+        check(bytes[299]) == std::byte{299 % 256};
+        check(bytes.read_from(fds[0], 10)) == 0;
+        ::close(fds[0]);
+    });
+#endif
+
+
+    using felspar::memory::test::counting_resource;
+
+
+    auto const mr = suite.test("memory resource", [](auto check) {
+        counting_resource resource;
+        {
+            felspar::memory::shared_bytes bytes{256, &resource};
+            check(bytes.size()) == 256u;
+            check(resource.allocations) == 1u;
+            auto const first = bytes.consume_first(16);
+            check(bytes.size()) == 240u;
+        }
+        check(resource.deallocations) == 1u;
+
+        {
+            felspar::memory::accumulation_buffer<std::string> strings{
+                    4, &resource};
+            strings.ensure_length(4, "hello");
+            check(resource.allocations) == 2u;
+            auto const first = strings.first(3);
+            strings.ensure_length(8, "world");
+            check(resource.allocations) == 3u;
+            check(strings[0]) == "hello";
+            check(strings[1]) == "world";
+            check(first[2]) == "hello";
+            strings = {};
+            check(resource.deallocations) == 2u;
+        }
+        check(resource.deallocations) == 3u;
+    });
+
+
+    auto const sp = suite.test("split", [](auto check) {
+        std::array<std::size_t, 3> const sizes{4, 8, 16};
+
+        felspar::memory::shared_bytes bytes{32};
+        auto slices = bytes.consume_split(sizes);
+        check(bytes.size()) == 4u;
+        check(slices[1].size()) == 8u;
+        check(slices[2].data() + 16) == bytes.data();
+        check([&]() { auto const s = bytes.consume_split(sizes); })
+                .throws(felspar::stdexcept::logic_error{"Buffer overrun"});
+        check(bytes.size()) == 4u;
+        felspar::memory::shared_bytes::release(slices);
+        check(slices[0].size()) == 0u;
+
+        felspar::memory::accumulation_buffer<std::byte> acc{64};
+        acc.ensure_length(30);
+        auto parts = acc.split(sizes);
+        check(acc.size()) == 2u;
+        check(parts[2].size()) == 16u;
+        check(parts[0].control_block()) == parts[2].control_block();
+    });
+
+
+    auto const cow = suite.test("copy on write", [](auto check) {
+        felspar::memory::shared_bytes bytes{8};
+        auto const *const original = bytes.data();
+        check(bytes.make_writable().data()) == original;
+        bytes.make_writable()[0] = std::byte{0};
+        bytes.make_writable()[7] = std::byte{7};
+
+        felspar::memory::shared_bytes const copy{bytes};
+        bytes.make_writable()[0] = std::byte{1};
+        check(bytes.data()) != original;
+        check(bytes.size()) == 8u;
+        check(bytes.memory()[7]) == std::byte{7};
+        check(copy.data()) == original;
+        check(copy.memory()[0]) == std::byte{0};
+        check(bytes.make_writable().data()) != original;
+    });
+
+
+    auto const weak = suite.test("weak shared_bytes", [](auto check) {
+        felspar::memory::weak_shared_bytes weak;
+        check(weak.expired()) == true;
+        {
+            felspar::memory::shared_bytes bytes{32};
+            weak = bytes;
+            auto const locked = weak.lock();
+            check(locked.data()) == bytes.data();
+            check(weak.size()) == 32u;
+        }
+        check(weak.expired()) == true;
+        check(weak.lock().size()) == 0u;
+    });
+
+
+    auto const compact = suite.test("compaction", [](auto check) {
+        counting_resource resource;
+        felspar::memory::accumulation_buffer<std::string> strings{
+                8, &resource};
+        for (std::size_t count{}; count < 100u; ++count) {
+            strings.ensure_length(5, "hello");
+            auto const message = strings.first(4);
+            check(message[3]) == "hello";
+        }
+        check(resource.allocations) == 1u;
+        check(strings.capacity()) == 8u;
+        check(strings.size()) == 1u;
+
+        /// A slice that is still in use stops the block being reused
+        strings = {8, &resource};
+        strings.ensure_length(6, "a");
+        auto const held = strings.first(6);
+        strings.ensure_length(4, "b");
+        check(resource.allocations) == 3u;
+        check(held[5]) == "a";
+
+        /// An oversized block is replaced by a smaller one
+        felspar::memory::accumulation_buffer<std::byte> bytes{16, &resource};
+        bytes.prepare(1000);
+        bytes.commit(1000);
+        auto const large = bytes.capacity();
+        check(large >= 1000u) == true;
+        bytes.first(1000);
+        auto const before = resource.allocations.load();
+        for (std::size_t count{}; count < 300u; ++count) {
+            bytes.prepare(10);
+            bytes.commit(10);
+            bytes.first(10);
+        }
+        check(resource.allocations) == before + 1u;
+        check(bytes.capacity() < large / 4u) == true;
+    });
+
+
+    auto const cc = suite.test("compaction after copy", [](auto check) {
+        felspar::memory::accumulation_buffer<int> a{16};
+        a.ensure_length(4, 1);
+        a.first(2);
+        {
+            /// The copy appends into the same block after our items
+            auto b = a;
+            b.ensure_length(6, 7);
+        }
+        a.ensure_length(16, 9);
+        auto const all = a.first(16);
+        check(all[0]) == 1;
+        check(all[1]) == 1;
+        check(all[2]) == 9;
+        check(all[15]) == 9;
+    });
+
+
+    auto const lb = suite.test("local shared_bytes", [](auto check) {
+        counting_resource resource;
+        {
+            felspar::memory::local_shared_bytes bytes{64, &resource};
+            auto const first = bytes.consume_first(16);
+            check(first.size()) == 16u;
+            check(bytes.size()) == 48u;
+            felspar::memory::shared_bytes const shared{bytes};
+            check(shared.data()) == bytes.data();
+            felspar::memory::shared_byte_view const view{shared};
+            check(view.size()) == 48u;
+        }
+        check(resource.allocations) == 1u;
+        check(resource.deallocations) == 1u;
+    });
+
+
 }
@@ -0,0 +1,112 @@
+#include <felspar/memory/concurrent-fixed-pool.pmr.hpp>
+#include <felspar/test.hpp>
+
+#include <algorithm>
+#include <thread>
+#include <vector>
+
+
+namespace {
+
+
+    auto const suite = felspar::testsuite("concurrent-fixed-pool.pmr");
+
+
+    auto const s = suite.test("small", [](auto check) {
+        felspar::memory::concurrent_fixed_pool fp{
+                512, felspar::pmr::new_delete_resource()};
+
+        void *a1 = fp.allocate(100);
+        void *a2 = fp.allocate(100);
+        check(a1) != a2;
+        fp.deallocate(a1, 100);
+        fp.deallocate(a2, 100);
+
+        void *a3 = fp.allocate(200);
+        check(a3) == a2;
+        fp.deallocate(a3, 200);
+    });
+
+
+    auto const lf = suite.test("lock free", [](auto check) {
+        felspar::memory::concurrent_fixed_pool fp{
+                32, felspar::pmr::new_delete_resource()};
+        if constexpr (felspar::memory::concurrent_fixed_pool::
+                              is_always_lock_free) {
+            check(fp.is_lock_free()) == true;
+        }
+    });
+
+
+    auto const b = suite.test("big", [](auto check) {
+        felspar::memory::concurrent_fixed_pool fp{
+                512, felspar::pmr::new_delete_resource()};
+
+        void *a1 = fp.allocate(1000);
+        void *a2 = fp.allocate(1000);
+        check(a1) != a2;
+        fp.deallocate(a1, 1000);
+        fp.deallocate(a2, 1000);
+    });
+
+
+    auto const p = suite.test("add blocks", [](auto check) {
+        felspar::memory::concurrent_fixed_pool fp{
+                32, felspar::pmr::new_delete_resource()};
+        fp.add_blocks(4);
+
+        auto *a1 = reinterpret_cast<std::byte *>(fp.allocate(32));
+        auto *a2 = reinterpret_cast<std::byte *>(fp.allocate(32));
+        check(a2) == a1 + 32;
+        fp.deallocate(a1, 32);
+        fp.deallocate(a2, 32);
+    });
+
+
+    auto const dg = suite.test("degenerate growth", [](auto check) {
+        felspar::memory::concurrent_fixed_pool fp{
+                32, felspar::pmr::new_delete_resource(), {0, 0, 0}};
+        std::vector<std::byte *> blocks;
+        for (std::size_t index{}; index < 3; ++index) {
+            blocks.push_back(reinterpret_cast<std::byte *>(fp.allocate(32)));
+            std::fill_n(blocks.back(), 32, std::byte{0xff});
+        }
+        check(blocks[0]) != blocks[1];
+        check(blocks[1]) != blocks[2];
+        for (auto *b : blocks) { fp.deallocate(b, 32); }
+    });
+
+
+    auto const t = suite.test("threads", [](auto check) {
+        constexpr std::size_t thread_count = 4, rounds = 20'000, held = 16;
+        felspar::memory::concurrent_fixed_pool fp{
+                sizeof(std::size_t), felspar::pmr::new_delete_resource()};
+
+        std::vector<std::size_t> errors(thread_count);
+        std::vector<std::thread> threads;
+        for (std::size_t id{}; id < thread_count; ++id) {
+            threads.emplace_back([&, id]() {
+                std::vector<std::size_t *> mine;
+                for (std::size_t round{}; round < rounds; ++round) {
+                    auto *v = reinterpret_cast<std::size_t *>(
+                            fp.allocate(sizeof(std::size_t)));
+                    *v = id;
+                    mine.push_back(v);
+                    if (mine.size() == held) {
+                        for (auto *m : mine) {
+                            if (*m != id) { ++errors[id]; }
+                            fp.deallocate(m, sizeof(std::size_t));
+                        }
+                        mine.clear();
+                    }
+                }
+                for (auto *m : mine) { fp.deallocate(m, sizeof(std::size_t)); }
+            });
+        }
+        for (auto &t : threads) { t.join(); }
+        check(std::count(errors.begin(), errors.end(), 0u))
+                == static_cast<long>(thread_count);
+    });
+
+
+}
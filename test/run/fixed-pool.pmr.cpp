@@ -1,6 +1,10 @@
 #include <felspar/memory/fixed-pool.pmr.hpp>
 #include <felspar/test.hpp>
 
+#include "../counting_resource.hpp"
+
+#include <vector>
+
 
 namespace {
 
@@ -8,6 +12,9 @@ namespace {
     auto const suite = felspar::testsuite("fixed-pool.pmr");
 
 
+    using felspar::memory::test::counting_resource;
+
+
     auto const s = suite.test("small", [](auto check) {
         felspar::memory::fixed_pool fp{
                 512, felspar::pmr::new_delete_resource()};
@@ -24,6 +31,25 @@ namespace {
     });
 
 
+    auto const t = suite.test("tiny", [](auto check) {
+        felspar::memory::fixed_pool fp{1, felspar::pmr::new_delete_resource()};
+
+        void *a1 = fp.allocate(1);
+        void *a2 = fp.allocate(1);
+        void *a3 = fp.allocate(1);
+        fp.deallocate(a1, 1);
+        fp.deallocate(a3, 1);
+        fp.deallocate(a2, 1);
+
+        check(fp.allocate(1)) == a2;
+        check(fp.allocate(1)) == a3;
+        check(fp.allocate(1)) == a1;
+        fp.deallocate(a1, 1);
+        fp.deallocate(a2, 1);
+        fp.deallocate(a3, 1);
+    });
+
+
     auto const b = suite.test("big", [](auto check) {
         felspar::memory::fixed_pool fp{
                 512, felspar::pmr::new_delete_resource()};
@@ -39,4 +65,76 @@ namespace {
     });
 
 
+    auto const r = suite.test("reserve", [](auto check) {
+        counting_resource upstream;
+        {
+            felspar::memory::fixed_pool fp{48, &upstream};
+            fp.reserve(100);
+            check(upstream.allocations) == 1u;
+            check(fp.free()) == 100u;
+
+            std::vector<std::byte *> blocks;
+            for (std::size_t index{}; index < 100; ++index) {
+                blocks.push_back(
+                        reinterpret_cast<std::byte *>(fp.allocate(48)));
+            }
+            check(upstream.allocations) == 1u;
+            check(fp.free()) == 0u;
+            for (std::size_t index{1}; index < blocks.size(); ++index) {
+                check(blocks[index]) == blocks[index - 1] + 48;
+            }
+
+            fp.reserve(10);
+            check(upstream.allocations) == 2u;
+            for (auto p : blocks) { fp.deallocate(p, 48); }
+            check(fp.free()) == 110u;
+            fp.reserve(100);
+            check(upstream.allocations) == 2u;
+        }
+        check(upstream.deallocations) == 2u;
+    });
+
+
+    auto const g = suite.test("growth", [](auto check) {
+        counting_resource upstream;
+        {
+            felspar::memory::fixed_pool fp{32, &upstream, {4, 2, 8}};
+            std::vector<void *> blocks;
+            for (std::size_t index{}; index < 4; ++index) {
+                blocks.push_back(fp.allocate(32));
+            }
+            check(upstream.allocations) == 1u;
+            blocks.push_back(fp.allocate(32));
+            check(upstream.allocations) == 2u;
+            check(fp.free()) == 7u;
+            for (std::size_t index{}; index < 7; ++index) {
+                blocks.push_back(fp.allocate(32));
+            }
+            check(upstream.allocations) == 2u;
+            blocks.push_back(fp.allocate(32));
+            check(upstream.allocations) == 3u;
+            check(fp.free()) == 7u;
+            for (auto p : blocks) { fp.deallocate(p, 32); }
+        }
+        check(upstream.deallocations) == 3u;
+    });
+
+
+    auto const dg = suite.test("degenerate growth", [](auto check) {
+        counting_resource upstream;
+        {
+            felspar::memory::fixed_pool fp{32, &upstream, {0, 0, 0}};
+            std::vector<void *> blocks;
+            for (std::size_t index{}; index < 3; ++index) {
+                blocks.push_back(fp.allocate(32));
+                check(fp.free()) == 0u;
+            }
+            check(upstream.allocations) == 3u;
+            for (auto p : blocks) { fp.deallocate(p, 32); }
+            check(fp.free()) == 3u;
+        }
+        check(upstream.deallocations) == 3u;
+    });
+
+
 }
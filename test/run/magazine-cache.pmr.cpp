@@ -0,0 +1,174 @@
+#include <felspar/memory/concurrent-fixed-pool.pmr.hpp>
+#include <felspar/memory/fixed-pool.pmr.hpp>
+#include <felspar/memory/magazine-cache.pmr.hpp>
+#include <felspar/test.hpp>
+
+#include "../counting_resource.hpp"
+
+#include <algorithm>
+#include <cstdlib>
+#include <new>
+#include <thread>
+#include <vector>
+
+
+namespace {
+    /// Set to make global allocations on this thread fail
+    thread_local bool fail_allocations = false;
+}
+
+
+void *operator new(std::size_t const bytes) {
+    if (fail_allocations) { throw std::bad_alloc{}; }
+    if (void *const p = std::malloc(bytes ? bytes : 1u)) { return p; }
+    throw std::bad_alloc{};
+}
+void *operator new(std::size_t const bytes, std::nothrow_t const &) noexcept {
+    if (fail_allocations) { return nullptr; }
+    return std::malloc(bytes ? bytes : 1u);
+}
+void operator delete(void *const p) noexcept { std::free(p); }
+void operator delete(void *const p, std::size_t) noexcept { std::free(p); }
+
+
+namespace {
+
+
+    auto const suite = felspar::testsuite("magazine-cache.pmr");
+
+
+    using felspar::memory::test::counting_resource;
+
+
+    auto const s = suite.test("single thread", [](auto check) {
+        counting_resource upstream;
+        {
+            felspar::memory::magazine_cache<4> mc{24, &upstream};
+            check(mc.block_size()) == 24u;
+
+            void *a1 = mc.allocate(24);
+            void *a2 = mc.allocate(10);
+            check(upstream.allocations.load()) == 2u;
+            mc.deallocate(a1, 24);
+            mc.deallocate(a2, 10);
+            check(upstream.deallocations.load()) == 0u;
+
+            check(mc.allocate(24)) == a2;
+            check(mc.allocate(24)) == a1;
+            check(upstream.allocations.load()) == 2u;
+            mc.deallocate(a1, 24);
+            mc.deallocate(a2, 24);
+        }
+        check(upstream.deallocations.load()) == 2u;
+    });
+
+
+    auto const d = suite.test("depot", [](auto check) {
+        counting_resource upstream;
+        {
+            felspar::memory::magazine_cache<4> mc{32, &upstream};
+            std::vector<void *> blocks;
+            for (std::size_t index{}; index < 20; ++index) {
+                blocks.push_back(mc.allocate(32));
+            }
+            check(upstream.allocations.load()) == 20u;
+            /// Fills both magazines and then sends full ones to the depot
+            for (auto p : blocks) { mc.deallocate(p, 32); }
+            check(upstream.deallocations.load()) == 0u;
+            /// All allocations are now served from the magazines and depot
+            for (auto &p : blocks) { p = mc.allocate(32); }
+            check(upstream.allocations.load()) == 20u;
+            for (auto p : blocks) { mc.deallocate(p, 32); }
+        }
+        check(upstream.deallocations.load()) == 20u;
+    });
+
+
+    auto const b = suite.test("big", [](auto check) {
+        counting_resource upstream;
+        felspar::memory::magazine_cache<4> mc{32, &upstream};
+        void *a1 = mc.allocate(100);
+        check(upstream.allocations.load()) == 1u;
+        mc.deallocate(a1, 100);
+        check(upstream.deallocations.load()) == 1u;
+    });
+
+
+    auto const fp = suite.test("fixed_pool upstream", [](auto check) {
+        counting_resource upstream;
+        felspar::memory::fixed_pool pool{24, &upstream, {16, 2, 16}};
+        felspar::memory::magazine_cache<4> mc{24, &pool};
+        void *a1 = mc.allocate(24);
+        void *a2 = mc.allocate(8);
+        /// Both blocks come out of the pool's first chunk
+        check(pool.free()) == 14u;
+        check(upstream.allocations.load()) == 1u;
+        mc.deallocate(a1, 24);
+        mc.deallocate(a2, 8);
+    });
+
+
+    auto const nt = suite.test("deallocate without memory", [](auto check) {
+        counting_resource upstream;
+        felspar::memory::magazine_cache<2> mc{32, &upstream};
+        std::vector<void *> blocks;
+        for (std::size_t index{}; index < 6; ++index) {
+            blocks.push_back(mc.allocate(32));
+        }
+        /// Once both magazines are full there's nowhere to put the blocks
+        fail_allocations = true;
+        for (auto p : blocks) { mc.deallocate(p, 32); }
+        fail_allocations = false;
+        check(upstream.deallocations.load()) == 2u;
+
+        /// A thread without any magazines gives its block straight back
+        void *const block = mc.allocate(32);
+        std::thread{[&]() {
+            fail_allocations = true;
+            mc.deallocate(block, 32);
+            fail_allocations = false;
+        }}.join();
+        check(upstream.deallocations.load()) == 3u;
+    });
+
+
+    auto const t = suite.test("threads", [](auto check) {
+        constexpr std::size_t thread_count = 4, rounds = 20'000, held = 50;
+        counting_resource upstream;
+        felspar::memory::concurrent_fixed_pool pool{
+                sizeof(std::size_t), &upstream};
+        felspar::memory::magazine_cache<8> mc{sizeof(std::size_t), &pool};
+
+        std::vector<std::size_t> errors(thread_count);
+        std::vector<std::thread> threads;
+        for (std::size_t id{}; id < thread_count; ++id) {
+            threads.emplace_back([&, id]() {
+                std::vector<std::size_t *> mine;
+                for (std::size_t round{}; round < rounds; ++round) {
+                    auto *v = reinterpret_cast<std::size_t *>(
+                            mc.allocate(sizeof(std::size_t)));
+                    *v = id;
+                    mine.push_back(v);
+                    if (mine.size() == held) {
+                        for (auto *m : mine) {
+                            if (*m != id) { ++errors[id]; }
+                            mc.deallocate(m, sizeof(std::size_t));
+                        }
+                        mine.clear();
+                    }
+                }
+                for (auto *m : mine) { mc.deallocate(m, sizeof(std::size_t)); }
+            });
+        }
+        for (auto &t : threads) { t.join(); }
+        check(std::count(errors.begin(), errors.end(), 0u))
+                == static_cast<long>(thread_count);
+        /**
+         * The pool serves the blocks in a handful of growing chunks, rather
+         * than passing every refill on to its upstream.
+         */
+        check(upstream.allocations.load() < 16u) == true;
+    });
+
+
+}
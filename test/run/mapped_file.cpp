@@ -0,0 +1,76 @@
+#include <felspar/memory/mapped_file.hpp>
+#include <felspar/test.hpp>
+
+#include <fstream>
+#include <string>
+#include <string_view>
+
+
+namespace {
+
+
+    auto const suite = felspar::testsuite("mapped_file");
+
+
+#if __has_include(<sys/mman.h>) and __has_include(<unistd.h>)
+    struct temporary_file {
+        std::filesystem::path path = std::filesystem::temp_directory_path()
+                / ("felspar-memory-mapped-" + std::to_string(::getpid()));
+
+        temporary_file(std::string const &content) {
+            std::ofstream{path, std::ios::binary} << content;
+        }
+        ~temporary_file() { std::filesystem::remove(path); }
+    };
+
+
+    auto const map = suite.test("map", [](auto check) {
+        temporary_file const file{"Hello mapped world"};
+        felspar::memory::shared_buffer<std::byte const> slice;
+        {
+            auto const mapped = felspar::memory::map_file(
+                    file.path,
+                    felspar::memory::mapped_file::access::sequential);
+            check(mapped.size()) == 18u;
+            check(mapped[0]) == std::byte{'H'};
+            check(mapped.control_block()->use_count()) == 1u;
+            slice = mapped;
+        }
+        check(slice.control_block()->use_count()) == 1u;
+        check(slice[17]) == std::byte{'d'};
+        felspar::memory::mapped_file::advise(
+                slice.cmemory().subspan(6, 6),
+                felspar::memory::mapped_file::access::random);
+
+        {
+            auto bytes = felspar::memory::map_file<
+                    felspar::memory::shared_bytes>(file.path);
+            auto const hello = bytes.consume_first(5);
+            check(bytes.size()) == 13u;
+            hello.memory()[0] = std::byte{'J'};
+            check(hello.memory()[0]) == std::byte{'J'};
+        }
+        /// Writes to the private mapping don't reach the file
+        check(slice[0]) == std::byte{'H'};
+        auto const again = felspar::memory::map_file(file.path);
+        check(again[0]) == std::byte{'H'};
+    });
+
+
+    auto const errors = suite.test("errors", [](auto check) {
+        temporary_file const empty{""};
+        check(felspar::memory::map_file(empty.path).empty()) == true;
+        try {
+            felspar::memory::map_file("/this/file/does/not/exist");
+            check(false) == true;
+        } catch (felspar::memory::system_error const &e) {
+            check(e.code().value()) == ENOENT;
+            check(std::string_view{e.location().file_name()}.ends_with(
+                    "mapped_file.cpp"))
+                    == true;
+        }
+    });
+#endif
+
+
+}
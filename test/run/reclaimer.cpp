@@ -0,0 +1,103 @@
+#include <felspar/memory/reclaimer.hpp>
+#include <felspar/memory/shared_buffer.hpp>
+#include <felspar/test.hpp>
+
+#include "../counted.hpp"
+
+#include <thread>
+#include <vector>
+
+
+namespace {
+
+
+    auto const suite = felspar::testsuite("reclaimer");
+
+
+    using felspar::memory::test::counted;
+
+
+    auto const rl = suite.test("retire_list", [](auto check) {
+        felspar::memory::retire_list list;
+        check(list.empty()) == true;
+        {
+            auto items = felspar::memory::shared_buffer<counted>::allocate(4);
+            felspar::memory::control::defer_reclamation(
+                    items.control_block(), list);
+            auto const copy = items.first(2);
+            items = {};
+            check(list.empty()) == true;
+        }
+        check(list.empty()) == false;
+        check(counted::live) == 4u;
+        check(list.drain()) == 1u;
+        check(list.empty()) == true;
+        check(counted::live) == 0u;
+
+        {
+            auto local =
+                    felspar::memory::local_shared_buffer<counted>::allocate(2);
+            felspar::memory::control::defer_reclamation(
+                    local.control_block(), list);
+            felspar::memory::weak_shared_buffer weak{local};
+            local = {};
+            check(counted::live) == 2u;
+            check(weak.lock().empty()) == true;
+            check(list.drain()) == 1u;
+            check(counted::live) == 0u;
+        }
+
+        {
+            /// Biased blocks keep the list in the same record as their counts
+            auto biased =
+                    felspar::memory::biased_shared_buffer<counted>::allocate(3);
+            felspar::memory::control::defer_reclamation(
+                    biased.control_block(), list);
+            auto const copy = biased;
+            biased = {};
+            check(copy.control_block()->use_count()) == 1u;
+        }
+        check(counted::live) == 3u;
+        check(list.drain()) == 1u;
+        check(counted::live) == 0u;
+
+        {
+            auto items = felspar::memory::shared_buffer<counted>::allocate(1);
+            felspar::memory::control::defer_reclamation(
+                    items.control_block(), list);
+        }
+        check(counted::live) == 1u;
+    });
+
+
+    auto const bg = suite.test("background", [](auto check) {
+        {
+            felspar::memory::reclaimer reclaimer{std::chrono::microseconds{50}};
+            std::vector<std::thread> threads;
+            for (std::size_t index{}; index < 4u; ++index) {
+                threads.emplace_back([&reclaimer]() {
+                    for (std::size_t count{}; count < 1000u; ++count) {
+                        auto items = felspar::memory::shared_buffer<
+                                counted>::allocate(3);
+                        reclaimer.adopt(items.control_block());
+                    }
+                });
+            }
+            for (auto &t : threads) { t.join(); }
+            while (counted::live) { std::this_thread::yield(); }
+
+            auto items = felspar::memory::shared_buffer<counted>::allocate(2);
+            reclaimer.adopt(items.control_block());
+            items = {};
+            while (counted::live) { std::this_thread::yield(); }
+            check(reclaimer.retired().empty()) == true;
+            check(reclaimer.drain()) == 0u;
+
+            items = felspar::memory::shared_buffer<counted>::allocate(2);
+            reclaimer.adopt(items.control_block());
+        }
+        check(counted::live) == 0u;
+    });
+
+
+}
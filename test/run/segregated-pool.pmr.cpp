@@ -0,0 +1,83 @@
+#include <felspar/memory/segregated-pool.pmr.hpp>
+#include <felspar/test.hpp>
+
+#include <felspar/exceptions.hpp>
+
+
+namespace {
+
+
+    auto const suite = felspar::testsuite("segregated-pool.pmr");
+
+
+    auto const dc = suite.test("default classes", [](auto check) {
+        constexpr auto classes =
+                felspar::memory::segregated_pool::default_size_classes();
+        check(classes.front()) == 16u;
+        check(classes[3]) == 64u;
+        check(classes[4]) == 80u;
+        check(classes[8]) == 160u;
+        check(classes.back()) == 4096u;
+        for (std::size_t index{1}; index < classes.size(); ++index) {
+            check(classes[index]) > classes[index - 1];
+            check(classes[index] % 16u) == 0u;
+        }
+    });
+
+
+    auto const a = suite.test("allocate", [](auto check) {
+        felspar::memory::segregated_pool sp{
+                felspar::pmr::new_delete_resource()};
+        check(sp.largest_class()) == 4096u;
+
+        void *a1 = sp.allocate(1);
+        void *a2 = sp.allocate(70);
+        void *a3 = sp.allocate(4096);
+        void *a4 = sp.allocate(5000);
+
+        auto const stats = sp.statistics();
+        check(stats[0].block_size) == 16u;
+        check(stats[0].allocations) == 1u;
+        check(stats[0].requested_bytes) == 1u;
+        check(stats[4].block_size) == 80u;
+        check(stats[4].live()) == 1u;
+        check(stats[4].fragmentation()) == 1.0 - 70.0 / 80.0;
+        check(stats.back().live()) == 1u;
+
+        sp.deallocate(a1, 1);
+        sp.deallocate(a2, 70);
+        sp.deallocate(a3, 4096);
+        sp.deallocate(a4, 5000);
+        check(stats[4].live()) == 0u;
+        check(stats[4].deallocations) == 1u;
+
+        /// Blocks are re-used by their size class
+        check(sp.allocate(75)) == a2;
+        sp.deallocate(a2, 75);
+    });
+
+
+    auto const c = suite.test("custom classes", [](auto check) {
+        std::array<std::size_t, 3> const classes{24, 100, 1000};
+        felspar::memory::segregated_pool sp{
+                classes, felspar::pmr::new_delete_resource()};
+        auto const stats = sp.statistics();
+        check(stats.size()) == 3u;
+        check(stats[0].block_size) == 32u;
+        check(stats[1].block_size) == 112u;
+        check(stats[2].block_size) == 1008u;
+
+        void *a1 = sp.allocate(33);
+        check(stats[1].allocations) == 1u;
+        sp.deallocate(a1, 33);
+
+        std::array<std::size_t, 2> const backwards{100, 10};
+        check([&]() {
+            felspar::memory::segregated_pool{
+                    backwards, felspar::pmr::new_delete_resource()};
+        }).throws(felspar::stdexcept::logic_error{
+                "Size classes must be in ascending order"});
+    });
+
+
+}
@@ -1,6 +1,16 @@
 #include <felspar/memory/shared_buffer.hpp>
 #include <felspar/test.hpp>
 
+#include "../counted.hpp"
+#include "../counting_resource.hpp"
+
+#include <felspar/exceptions.hpp>
+
+#include <array>
+#include <string>
+#include <thread>
+#include <vector>
+
 
 namespace {
 
@@ -54,4 +64,314 @@ namespace {
     });
 
 
+    using felspar::memory::test::counted;
+
+
+    auto const single = suite.test("single allocation", [](auto check) {
+        auto bytes = felspar::memory::shared_buffer<std::byte>::allocate(64);
+        auto const *const control =
+                reinterpret_cast<std::byte const *>(bytes.control_block());
+        auto const *const data = bytes.data();
+        check(data > control) == true;
+        check(data - control <= 64) == true;
+        /// Biased counting and deferred reclamation don't add to the block
+        check(sizeof(felspar::memory::control) <= 3 * sizeof(void *)) == true;
+
+        {
+            auto items =
+                    felspar::memory::shared_buffer<counted>::allocate(10);
+            check(counted::live) == 10u;
+            auto const copy = items.first(5);
+            items = {};
+            check(counted::live) == 10u;
+        }
+        check(counted::live) == 0u;
+    });
+
+
+    using felspar::memory::test::counting_resource;
+
+
+    auto const mr = suite.test("memory resource", [](auto check) {
+        counting_resource resource;
+        {
+            auto strings =
+                    felspar::memory::shared_buffer<std::string>::allocate(
+                            8, "hello", &resource);
+            check(resource.allocations) == 1u;
+            check(strings[7]) == "hello";
+            auto const copy = strings.first(4);
+            strings = {};
+            check(resource.deallocations) == 0u;
+        }
+        check(resource.deallocations) == 1u;
+
+        auto wrapped = felspar::memory::shared_buffer<int>::wrap(
+                std::vector{1, 2, 3}, &resource);
+        check(resource.allocations) == 2u;
+        check(wrapped.at(2)) == 3;
+        wrapped = {};
+        check(resource.deallocations) == 2u;
+    });
+
+
+    auto const sp = suite.test("split", [](auto check) {
+        {
+            auto items =
+                    felspar::memory::shared_buffer<counted>::allocate(10);
+            std::array<std::size_t, 3> const sizes{2, 3, 4};
+            auto slices = items.split(sizes);
+            check(slices.size()) == 3u;
+            check(slices[0].size()) == 2u;
+            check(slices[1].size()) == 3u;
+            check(slices[2].size()) == 4u;
+            check(slices[1].data()) == items.data() + 2;
+            check(slices[2].control_block()) == items.control_block();
+            check(items.size()) == 10u;
+
+            std::array<std::size_t, 2> const overrun{6, 5};
+            check([&]() { auto const s = items.split(overrun); })
+                    .throws(felspar::stdexcept::logic_error{"Buffer overrun"});
+
+            items = {};
+            check(counted::live) == 10u;
+            felspar::memory::shared_buffer<counted>::release(slices);
+            check(slices[2].empty()) == true;
+            check(counted::live) == 0u;
+        }
+        {
+            auto local =
+                    felspar::memory::local_shared_buffer<counted>::allocate(6);
+            std::array<std::size_t, 3> const sizes{2, 2, 2};
+            auto slices = local.split(sizes);
+            local = {};
+            slices.push_back(slices[0]);
+            felspar::memory::local_shared_buffer<counted>::release(slices);
+            check(counted::live) == 0u;
+        }
+        {
+            auto biased =
+                    felspar::memory::biased_shared_buffer<counted>::allocate(6);
+            std::array<std::size_t, 6> const sizes{1, 1, 1, 1, 1, 1};
+            auto slices = biased.split(sizes);
+            std::thread{[s = slices[5]]() {}}.join();
+            biased = {};
+            felspar::memory::biased_shared_buffer<counted>::release(slices);
+            check(counted::live) == 0u;
+        }
+    });
+
+
+    auto const cow = suite.test("copy on write", [](auto check) {
+        auto strings =
+                felspar::memory::shared_buffer<std::string>::allocate(4, "a");
+        check(strings.control_block()->use_count()) == 1u;
+        check(strings.control_block()->is_unique()) == true;
+        auto const *const original = strings.data();
+        check(strings.make_writable().data()) == original;
+
+        auto const copy = strings;
+        check(strings.control_block()->use_count()) == 2u;
+        check(strings.control_block()->is_unique()) == false;
+        strings.make_writable()[0] = "b";
+        check(strings.data()) != original;
+        check(strings.control_block()->is_unique()) == true;
+        check(strings[0]) == "b";
+        check(strings[3]) == "a";
+        check(copy[0]) == "a";
+        check(copy.control_block()->is_unique()) == true;
+
+        auto local =
+                felspar::memory::local_shared_buffer<std::string>::allocate(2);
+        auto const part = local.first(1);
+        check(local.control_block()->use_count()) == 2u;
+        local.make_writable()[1] = "c";
+        check(part.control_block()->use_count()) == 1u;
+        check(local.control_block()->use_count()) == 1u;
+
+        auto biased =
+                felspar::memory::biased_shared_buffer<std::string>::allocate(2);
+        auto const other = biased;
+        check(biased.control_block()->use_count()) == 2u;
+        std::thread{[&]() {
+            check(biased.control_block()->is_unique()) == false;
+        }}.join();
+        biased.make_writable()[0] = "d";
+        check(other.control_block()->is_unique()) == true;
+        check(biased[0]) == "d";
+    });
+
+
+    auto const weak = suite.test(
+            "weak references",
+            [](auto check) {
+                felspar::memory::weak_shared_buffer<counted> weak;
+                check(weak.expired()) == true;
+                check(weak.lock().empty()) == true;
+                {
+                    auto items =
+                            felspar::memory::shared_buffer<counted>::allocate(
+                                    4);
+                    weak = items;
+                    check(weak.expired()) == false;
+                    auto const locked = weak.lock();
+                    check(locked.data()) == items.data();
+                    check(items.control_block()->use_count()) == 2u;
+                }
+                check(counted::live) == 0u;
+                check(weak.expired()) == true;
+                check(weak.lock().empty()) == true;
+                auto const copy = weak;
+                weak = {};
+                check(copy.lock().empty()) == true;
+            },
+            [](auto check) {
+                /// Wrapped vectors give their memory back straight away
+                felspar::memory::weak_shared_buffer<counted> weak;
+                {
+                    auto wrapped = felspar::memory::shared_buffer<
+                            counted>::wrap(std::vector<counted>(3));
+                    weak = wrapped;
+                    check(counted::live) == 3u;
+                }
+                check(counted::live) == 0u;
+                check(weak.expired()) == true;
+            },
+            [](auto check) {
+                auto local = felspar::memory::local_shared_buffer<
+                        counted>::allocate(2);
+                felspar::memory::weak_shared_buffer weak{local};
+                auto locked = weak.lock();
+                check(local.control_block()->use_count()) == 2u;
+                local = {};
+                locked = {};
+                check(counted::live) == 0u;
+                check(weak.lock().empty()) == true;
+            },
+            [](auto check) {
+                auto biased = felspar::memory::biased_shared_buffer<
+                        counted>::allocate(2);
+                felspar::memory::weak_shared_buffer weak{biased};
+                std::thread{[&weak, &check]() {
+                    auto const locked = weak.lock();
+                    check(locked.size()) == 2u;
+                }}.join();
+                check(weak.lock().size()) == 2u;
+                biased = {};
+                felspar::memory::control::merge_queued();
+                check(counted::live) == 0u;
+                std::thread{[&weak, &check]() {
+                    check(weak.lock().empty()) == true;
+                }}.join();
+                check(weak.expired()) == true;
+            });
+
+
+    auto const lc = suite.test("local counting", [](auto check) {
+        {
+            auto local =
+                    felspar::memory::local_shared_buffer<counted>::allocate(4);
+            check(counted::live) == 4u;
+            auto const copy = local;
+            auto const part = local.first(2);
+            check(part.control_block()) == local.control_block();
+            local = {};
+            check(counted::live) == 4u;
+        }
+        check(counted::live) == 0u;
+
+        std::thread thread;
+        {
+            auto local =
+                    felspar::memory::local_shared_buffer<counted>::allocate(4);
+            felspar::memory::shared_buffer<counted> shared{local};
+            check(shared.control_block()) == local.control_block();
+            thread = std::thread{[s = std::move(shared)]() mutable {
+                for (std::size_t count{}; count < 1000u; ++count) {
+                    auto const copy = s;
+                }
+                s = {};
+            }};
+            for (std::size_t count{}; count < 1000u; ++count) {
+                auto const copy = local;
+            }
+            felspar::memory::local_shared_buffer<counted> back{
+                    felspar::memory::shared_buffer<counted>{local}};
+            check(back.size()) == 4u;
+        }
+        thread.join();
+        check(counted::live) == 0u;
+    });
+
+
+    auto const bc = suite.test(
+            "biased counting",
+            [](auto check) {
+                {
+                    auto biased = felspar::memory::biased_shared_buffer<
+                            counted>::allocate(4);
+                    auto const copy = biased;
+                    auto const part = biased.first(2);
+                    biased = {};
+                    check(counted::live) == 4u;
+                }
+                check(counted::live) == 0u;
+            },
+            [](auto check) {
+                /// Copies made and released on another thread
+                {
+                    auto biased = felspar::memory::biased_shared_buffer<
+                            counted>::allocate(4);
+                    std::thread thread{[b = biased]() {
+                        for (std::size_t count{}; count < 1000u; ++count) {
+                            auto const copy = b;
+                        }
+                    }};
+                    for (std::size_t count{}; count < 1000u; ++count) {
+                        auto const copy = biased;
+                    }
+                    thread.join();
+                    check(counted::live) == 4u;
+                }
+                check(counted::live) == 0u;
+            },
+            [](auto check) {
+                /// The last reference is released by another thread
+                auto biased = felspar::memory::biased_shared_buffer<
+                        counted>::allocate(4);
+                std::thread{[b = std::move(biased)]() {}}.join();
+                check(counted::live) == 4u;
+                felspar::memory::control::merge_queued();
+                check(counted::live) == 0u;
+            },
+            [](auto check) {
+                /// The owning thread exits before the last reference goes
+                felspar::memory::biased_shared_buffer<counted> biased;
+                std::thread{[&biased]() {
+                    biased = felspar::memory::biased_shared_buffer<
+                            counted>::allocate(4);
+                }}.join();
+                check(counted::live) == 4u;
+                biased = {};
+                check(counted::live) == 0u;
+            },
+            [](auto check) {
+                /// Shared with atomic handles
+                {
+                    auto biased = felspar::memory::biased_shared_buffer<
+                            counted>::allocate(4);
+                    felspar::memory::shared_buffer<counted> shared{biased};
+                    std::thread thread{[s = std::move(shared)]() {
+                        for (std::size_t count{}; count < 1000u; ++count) {
+                            auto const copy = s;
+                        }
+                    }};
+                    biased = {};
+                    thread.join();
+                }
+                felspar::memory::control::merge_queued();
+                check(counted::live) == 0u;
+            });
+
+
 }
@@ -0,0 +1,100 @@
+#include <felspar/exceptions.hpp>
+#include <felspar/memory/shared_memory.hpp>
+#include <felspar/test.hpp>
+
+#if __has_include(<sys/wait.h>)
+#include <sys/wait.h>
+#endif
+
+
+namespace {
+
+
+    auto const suite = felspar::testsuite("shared_memory");
+
+
+#if __has_include(<sys/mman.h>) and __has_include(<unistd.h>)
+    using felspar::memory::shared_memory;
+
+
+    auto const allocate = suite.test("allocate", [](auto check) {
+        auto bytes = shared_memory::allocate(64);
+        check(bytes.size()) == 64u;
+        check(bytes.memory()[0]) == std::byte{};
+        check(shared_memory::mappings(bytes)) == 1u;
+
+        auto const tail = bytes.consume_first(16);
+        auto const d = shared_memory::export_descriptor(bytes);
+        check(d.fd) >= 0;
+        check(d.offset) == 16u;
+        check(d.size) == 48u;
+    });
+
+
+    auto const imports = suite.test("import", [](auto check) {
+        auto bytes = shared_memory::allocate(32);
+        auto const head = bytes.consume_first(8);
+        {
+            auto other = shared_memory::import_descriptor(
+                    shared_memory::export_descriptor(bytes));
+            check(shared_memory::mappings(bytes)) == 2u;
+            check(other.size()) == 24u;
+            /// Both mappings are of the same memory
+            other.memory()[0] = std::byte{'x'};
+            check(bytes.memory()[0]) == std::byte{'x'};
+            check(other.data() != bytes.data()) == true;
+        }
+        check(shared_memory::mappings(bytes)) == 1u;
+    });
+
+
+    auto const errors = suite.test("errors", [](auto check) {
+        felspar::memory::shared_bytes heap{8};
+        check([&]() {
+            [[maybe_unused]] auto const d =
+                    shared_memory::export_descriptor(heap);
+        }).throws(felspar::stdexcept::logic_error{
+                "The memory isn't in a shared memory segment"});
+
+        auto bytes = shared_memory::allocate(8);
+        auto d = shared_memory::export_descriptor(bytes);
+        d.size = 9u;
+        check([&]() {
+            [[maybe_unused]] auto const other =
+                    shared_memory::import_descriptor(d);
+        }).throws(felspar::stdexcept::logic_error{
+                "The descriptor is outside of the segment"});
+        check(shared_memory::mappings(bytes)) == 1u;
+    });
+
+
+#if __has_include(<sys/wait.h>)
+    auto const processes = suite.test("across processes", [](auto check) {
+        auto bytes = shared_memory::allocate(16);
+        bytes.memory()[0] = std::byte{'p'};
+        auto const d = shared_memory::export_descriptor(bytes);
+        auto const child = ::fork();
+        if (child == 0) {
+            /// The child inherits the descriptor and maps the segment again
+            bool seen = false;
+            {
+                auto other = shared_memory::import_descriptor(d);
+                seen = other.memory()[0] == std::byte{'p'}
+                        and shared_memory::mappings(other) == 2u;
+                other.memory()[1] = std::byte{'c'};
+            }
+            ::_exit(seen ? 0 : 1);
+        }
+        check(child) > 0;
+        int status = {};
+        check(::waitpid(child, &status, 0)) == child;
+        check(WIFEXITED(status)) == true;
+        check(WEXITSTATUS(status)) == 0;
+        check(bytes.memory()[1]) == std::byte{'c'};
+        check(shared_memory::mappings(bytes)) == 1u;
+    });
+#endif
+#endif
+
+
+}
@@ -27,4 +27,30 @@ namespace {
     });
 
 
+    auto const ta = suite.test("try_allocate", [](auto check) {
+        felspar::memory::slab_storage<64u, 8u> slab;
+        auto const base = reinterpret_cast<std::byte const *>(&slab);
+
+        auto a1 = slab.try_allocate(1u);
+        check(a1) == base;
+        auto a2 = slab.try_allocate(1u, 32u);
+        check(reinterpret_cast<std::uintptr_t>(a2) % 32u) == 0u;
+        check(slab.try_allocate(64u)) == nullptr;
+        check(slab.free()) == 64u - std::size_t(a2 + 8 - base);
+    });
+
+
+    auto const rw = suite.test("rewind", [](auto check) {
+        felspar::memory::slab_storage<64u, 8u> slab;
+
+        auto a1 = slab.allocate(8u);
+        auto const marker = slab.checkpoint();
+        auto a2 = slab.allocate(8u);
+        check(a2) == a1 + 8;
+        slab.rewind(marker);
+        check(slab.free()) == 56u;
+        check(slab.allocate(8u)) == a2;
+    });
+
+
 }
@@ -3,6 +3,8 @@
 
 #include <felspar/exceptions.hpp>
 
+#include <array>
+
 
 namespace {
 
@@ -40,9 +42,79 @@ namespace {
         check(a2) == reinterpret_cast<std::byte const *>(&stack) + 16u;
         check(stack.free()) == stack.storage_bytes - 32u;
 
-        check([&]() { [[maybe_unused]] auto _ = stack.allocate(8u); })
+        auto a3 = stack.allocate(8u);
+        check(a3) == reinterpret_cast<std::byte const *>(&stack) + 32u;
+        auto a4 = stack.allocate(16u);
+        check(a4) == reinterpret_cast<std::byte const *>(&stack) + 48u;
+        check(stack.free()) == 0u;
+
+        check([&]() { [[maybe_unused]] auto _ = stack.allocate(1u); })
+                .throws(felspar::stdexcept::bad_alloc{
+                        "Out of free memory -- memory exhausted"});
+
+        stack.deallocate(a1, 1u);
+        stack.deallocate(a3, 8u);
+        check(stack.free()) == 32u;
+        check([&]() { [[maybe_unused]] auto _ = stack.allocate(32u); })
                 .throws(felspar::stdexcept::bad_alloc{
-                        "Out of allocation bookkeeping slots"});
+                        "Out of free memory -- memory fragmentation"});
+
+        stack.deallocate(a2, 1u);
+        auto a5 = stack.allocate(32u);
+        check(a5) == reinterpret_cast<std::byte const *>(&stack);
+    });
+
+
+    auto const bk = suite.test("bookkeeping", [](auto check) {
+        felspar::memory::stack_storage<64u, 1u, 8u> stack;
+
+        auto a1 = stack.allocate(1u);
+        auto a2 = stack.allocate(1u);
+        auto a3 = stack.allocate(1u);
+        auto a4 = stack.allocate(1u);
+        auto a5 = stack.allocate(1u);
+
+        stack.deallocate(a1, 1u);
+        /// There is only one bookkeeping slot, so this block isn't tracked
+        stack.deallocate(a3, 1u);
+        check(stack.free()) == 32u;
+        /// The top can't come down past the untracked block
+        stack.deallocate(a5, 1u);
+        check(stack.free()) == 40u;
+        stack.deallocate(a4, 1u);
+        check(stack.free()) == 48u;
+
+        std::byte outside[8];
+        check([&]() { stack.deallocate(outside, 1u); })
+                .throws(felspar::stdexcept::logic_error{
+                        "Bookkeeping entry for allocation not found"});
+        check([&]() { stack.deallocate(a4 + 8u, 1u); })
+                .throws(felspar::stdexcept::logic_error{
+                        "Bookkeeping entry for allocation not found"});
+
+        /// Once everything is freed the untracked block is available again
+        stack.deallocate(a2, 1u);
+        check(stack.free()) == 64u;
+        check(stack.allocate(64u))
+                == reinterpret_cast<std::byte const *>(&stack);
+    });
+
+
+    auto const many = suite.test("many allocations", [](auto check) {
+        felspar::memory::stack_storage<8u << 10, 2u, 8u> stack;
+        std::array<std::byte *, 500> allocations;
+
+        for (auto &a : allocations) { a = stack.allocate(8u); }
+        check(stack.free()) == stack.storage_bytes - 4000u;
+        check(allocations.back())
+                == reinterpret_cast<std::byte const *>(&stack) + 3992u;
+
+        for (auto a = allocations.rbegin(); a != allocations.rend(); ++a) {
+            stack.deallocate(*a, 8u);
+        }
+        check(stack.free()) == stack.storage_bytes;
+        check(stack.allocate(8u))
+                == reinterpret_cast<std::byte const *>(&stack);
     });
 
 
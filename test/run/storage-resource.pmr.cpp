@@ -0,0 +1,96 @@
+#include <felspar/memory/slab.storage.hpp>
+#include <felspar/memory/stack.storage.hpp>
+#include <felspar/memory/storage-resource.pmr.hpp>
+#include <felspar/test.hpp>
+
+#include <felspar/exceptions.hpp>
+
+#ifndef FELSPAR_FORCE_PMR
+#include <set>
+#include <string>
+#include <vector>
+#endif
+
+
+namespace {
+
+
+    auto const suite = felspar::testsuite("storage-resource.pmr");
+
+
+    auto const sl = suite.test("slab", [](auto check) {
+        felspar::memory::storage_resource<felspar::memory::slab_storage<256>>
+                sr;
+
+        void *a1 = sr.allocate(1, 1);
+        check(sr.storage().owns(a1)) == true;
+        void *a2 = sr.allocate(8, 64);
+        check(reinterpret_cast<std::uintptr_t>(a2) % 64u) == 0u;
+        check(sr.storage().owns(a2)) == true;
+
+        check([&]() { [[maybe_unused]] auto _ = sr.allocate(1024); })
+                .throws(felspar::stdexcept::bad_alloc{
+                        "Storage exhausted and there is no upstream "
+                        "allocator"});
+        sr.deallocate(a2, 8, 64);
+        sr.deallocate(a1, 1, 1);
+    });
+
+
+    auto const st = suite.test("stack", [](auto check) {
+        felspar::memory::storage_resource<
+                felspar::memory::stack_storage<256, 8, 8>>
+                sr{felspar::pmr::new_delete_resource()};
+
+        void *a1 = sr.allocate(8, 8);
+        check(sr.storage().owns(a1)) == true;
+        void *a2 = sr.allocate(8, 32);
+        check(reinterpret_cast<std::uintptr_t>(a2) % 32u) == 0u;
+        check(sr.storage().owns(a2)) == true;
+
+        void *big = sr.allocate(1024);
+        check(sr.storage().owns(big)) == false;
+        sr.deallocate(big, 1024);
+
+        sr.deallocate(a2, 8, 32);
+        sr.deallocate(a1, 8, 8);
+        check(sr.storage().free()) == 256u;
+    });
+
+
+#ifndef FELSPAR_FORCE_PMR
+    auto const c = suite.test("std::pmr containers", [](auto check) {
+        felspar::memory::storage_resource<
+                felspar::memory::stack_storage<1024, 16>>
+                sr{felspar::pmr::new_delete_resource()};
+
+        std::pmr::vector<std::pmr::string> strings{&sr};
+        for (std::size_t index{}; index < 20; ++index) {
+            strings.emplace_back(
+                    "A string long enough that it needs an allocation");
+        }
+        check(strings.size()) == 20u;
+        check(strings.back().size()) == 48u;
+    });
+
+
+    auto const e = suite.test("interleaved erase", [](auto check) {
+        felspar::memory::storage_resource<
+                felspar::memory::stack_storage<8u << 10>>
+                sr;
+        {
+            std::pmr::set<int> numbers{&sr};
+            for (int n{}; n < 100; ++n) { numbers.insert(n); }
+            /// Frees far more blocks out of order than can be tracked
+            for (int n{}; n < 100; n += 2) { numbers.erase(n); }
+            check(numbers.size()) == 50u;
+            check(*numbers.begin()) == 1;
+            for (int n{}; n < 100; n += 2) { numbers.insert(n); }
+            check(numbers.size()) == 100u;
+        }
+        check(sr.storage().free()) == sr.storage().storage_bytes;
+    });
+#endif
+
+
+}
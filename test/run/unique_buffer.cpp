@@ -0,0 +1,81 @@
+#include <felspar/memory/unique_buffer.hpp>
+#include <felspar/test.hpp>
+
+#include "../counting_resource.hpp"
+
+#include <felspar/exceptions.hpp>
+
+#include <string>
+
+
+namespace {
+
+
+    auto const suite = felspar::testsuite("unique_buffer");
+
+
+    using felspar::memory::test::counting_resource;
+
+
+    auto const construct = suite.test("construct", [](auto check) {
+        felspar::memory::unique_buffer<int> empty;
+        check(empty.empty()) == true;
+        check(std::move(empty).share().control_block()) == nullptr;
+
+        counting_resource resource;
+        {
+            auto strings =
+                    felspar::memory::unique_buffer<std::string>::allocate(
+                            4, "hello", &resource);
+            check(strings.size()) == 4u;
+            strings[1] = "world";
+            check(strings.at(1)) == "world";
+            check([&]() { strings.at(4); })
+                    .throws(felspar::stdexcept::logic_error{"Buffer overrun"});
+
+            auto moved = std::move(strings);
+            check(strings.empty()) == true;
+            check(moved[3]) == "hello";
+        }
+        check(resource.allocations) == 1u;
+        check(resource.deallocations) == 1u;
+    });
+
+
+    auto const share = suite.test("share", [](auto check) {
+        counting_resource resource;
+        {
+            auto unique =
+                    felspar::memory::unique_buffer<std::string>::allocate(
+                            4, "hello", &resource);
+            unique[0] = "world";
+            auto const *const data = unique.data();
+            auto shared = std::move(unique).share();
+            check(unique.empty()) == true;
+            check(shared.data()) == data;
+            check(shared[0]) == "world";
+            check(resource.allocations) == 1u;
+            auto const part = shared.first(2);
+            shared = {};
+            check(resource.deallocations) == 0u;
+            check(part[1]) == "hello";
+        }
+        check(resource.allocations) == 1u;
+        check(resource.deallocations) == 1u;
+
+        {
+            auto unique = felspar::memory::unique_buffer<std::byte>::allocate(
+                    16, std::byte{}, &resource);
+            unique[3] = std::byte{3};
+            auto const bytes =
+                    std::move(unique)
+                            .share<felspar::memory::local_shared_bytes>();
+            check(bytes.size()) == 16u;
+            check(bytes.memory()[3]) == std::byte{3};
+        }
+        check(resource.allocations) == 2u;
+        check(resource.deallocations) == 2u;
+    });
+
+
+}